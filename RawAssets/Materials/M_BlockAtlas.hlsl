@@ -0,0 +1,18 @@
+// Reference for M_BlockAtlas, the material expected in UThemeData::BlockAtlasMaterial.
+//
+// Material setup (same as the block materials, Unlit, Masked, Two Sided):
+//  - TextureSampleParameter2D "Atlas" holding the theme's BlockAtlas. Not "SpriteTexture", which Paper2D replaces
+//    with the texture of the block sprite
+//  - ScalarParameter "ColumnCount" and "RowCount", matching BlockAtlasColumns and BlockAtlasRows
+//  - ScalarParameter "Intensity" (default 1), multiplied into Emissive Color so the blink groups keep working
+//  - A Custom node with the code below, Output Type CMOT Float 2, and the inputs:
+//       UV    <- TexCoord[0]
+//       Cell  <- VertexColor, R and G channels
+//       Grid  <- AppendVector(ColumnCount, RowCount)
+//    Its output drives the UVs of the texture sample. The sample RGB times Intensity goes into Emissive Color and
+//    its alpha into Opacity Mask.
+//
+// The block sprite must cover its whole texture so TexCoord[0] spans 0-1. The sprite color of every block holds its
+// atlas cell, see UThemeData::GetBlockAtlasColor().
+
+return (round(Cell * 255.0) + frac(UV)) / Grid;
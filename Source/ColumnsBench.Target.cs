@@ -0,0 +1,26 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+using UnrealBuildTool;
+using System.Collections.Generic;
+
+// Headless console program timing the gameplay algorithms of the ColumnsCore module. It neither renders nor
+// loads the engine, so it can run on build machines
+[SupportedPlatforms(UnrealPlatformClass.Desktop)]
+public class ColumnsBenchTarget : TargetRules
+{
+	public ColumnsBenchTarget(TargetInfo Target) : base(Target)
+	{
+		Type = TargetType.Program;
+		LinkType = TargetLinkType.Monolithic;
+		LaunchModuleName = "ColumnsBench";
+
+		bBuildDeveloperTools = false;
+		bUseMallocProfiler = false;
+		bCompileICU = false;
+		bCompileAgainstEngine = false;
+		bCompileAgainstCoreUObject = false;
+		bBuildWithEditorOnlyData = true;
+		bUseLoggingInShipping = true;
+		bIsBuildingConsoleApplication = true;
+	}
+}
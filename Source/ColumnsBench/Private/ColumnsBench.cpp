@@ -0,0 +1,586 @@
+/**
+ * This source code is provided as reference/companion material for the uColumnsTutorial
+ * that can be freely found at http://www.kehomsforge.com and should not be commercialized
+ * in any form. It should remain free!
+ *
+ * By Yuri Sarudiansky
+ */
+
+// Times the gameplay algorithms on seeded random boards of several sizes and fill ratios. Results are logged and,
+// if -csv=<file> is given, written as CSV so runs can be compared against a baseline. Other options:
+//    -seed=<int>       Seed used to generate the boards (default 1234)
+//    -mintime=<float>  Minimum amount of seconds each measurement runs (default 0.25)
+//    -verify           Instead of timing, check every match scanning path against the reference walkers on random
+//                      boards. The exit code is non zero if any of them disagrees
+//    -boards=<int>     Amount of random boards checked by -verify (default 4000)
+
+#include "RequiredProgramMainCPPInclude.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+#include "Misc/FileHelper.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+#include "ColumnsBoard.h"
+#include "CascadeResolver.h"
+#include "BlockPicker.h"
+#include "TweenScheduler.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogColumnsBench, Log, All);
+
+IMPLEMENT_APPLICATION(ColumnsBench, "ColumnsBench");
+
+
+namespace
+{
+   // Amount of block types in the generated boards, same as the default theme
+   const int32 BenchTypeCount = 6;
+
+   // Amount of pre-generated pieces used by the landing benchmarks
+   const int32 BenchPieceCount = 64;
+
+   // Results are accumulated here so the compiler can't discard the measured work
+   volatile int64 GBenchSink = 0;
+
+
+   // A player piece about to land on the board
+   struct FBenchPiece
+   {
+      int32 Column;
+      int32 Types[3];
+   };
+
+
+   class FBenchReport
+   {
+   public:
+      FBenchReport()
+      {
+         mCSV = TEXT("benchmark,variant,columns,rows,fill,ops,ns_per_op,cells_per_sec\n");
+      }
+
+      // Record a measurement. CellsPerOp is how many cells a single operation processes
+      void Add(const TCHAR* Benchmark, const TCHAR* Variant, int32 Columns, int32 Rows, float Fill, int64 Ops, double Seconds, int64 CellsPerOp)
+      {
+         const double ns_per_op = (Seconds * 1.0e9) / (double)Ops;
+         const double cells_per_sec = ((double)Ops * (double)CellsPerOp) / Seconds;
+
+         UE_LOG(LogColumnsBench, Display, TEXT("%-20s %-8s %4dx%-4d fill %.2f: %12.1f ns/op %12.0f cells/sec"), Benchmark, Variant, Columns, Rows, Fill, ns_per_op, cells_per_sec);
+
+         mCSV += FString::Printf(TEXT("%s,%s,%d,%d,%.2f,%lld,%.3f,%.0f\n"), Benchmark, Variant, Columns, Rows, Fill, Ops, ns_per_op, cells_per_sec);
+      }
+
+      bool Save(const FString& Path) const
+      {
+         return FFileHelper::SaveStringToFile(mCSV, *Path);
+      }
+
+   private:
+      FString mCSV;
+   };
+
+
+   // Repeatedly call Body, which performs OpsPerCall operations, for at least MinTime seconds. Returns the amount
+   // of performed operations and the elapsed time
+   template <typename FuncType>
+   int64 Measure(double MinTime, int64 OpsPerCall, double& OutSeconds, FuncType Body)
+   {
+      // Warm up caches and branch predictors
+      Body();
+
+      // Calls are done in growing batches so the timer is not read too often
+      int64 batch = 1;
+      int64 calls = 0;
+      const double start = FPlatformTime::Seconds();
+      do
+      {
+         for (int64 i = 0; i < batch; i++)
+         {
+            Body();
+         }
+         calls += batch;
+         OutSeconds = FPlatformTime::Seconds() - start;
+         batch = FMath::Min<int64>(batch * 2, 1 << 16);
+      } while (OutSeconds < MinTime);
+
+      return calls * OpsPerCall;
+   }
+
+
+   // Fill the board with random columns averaging Fill of the rows, then remove every matching run so the board
+   // looks like it would between two pieces
+   void BuildBoard(FColumnsBoard& Board, int32 Columns, int32 Rows, float Fill, FRandomStream& Stream)
+   {
+      Board.Init(Columns, Rows);
+      Board.SetMatchRules(FMatchRules(3, EMatchDirection::All));
+
+      TArray<int32> placed;
+      for (int32 col = 0; col < Columns; col++)
+      {
+         const int32 height = FMath::Min(FMath::RoundToInt(Stream.FRandRange(0.0f, 2.0f * Fill) * Rows), Rows);
+         for (int32 row = 0; row < height; row++)
+         {
+            const int32 cell_index = Board.GetCellIndex(col, row);
+            Board.SetCell(cell_index, Stream.RandRange(0, BenchTypeCount - 1));
+            placed.Add(cell_index);
+         }
+      }
+
+      FCascadeResolver resolver;
+      resolver.ResolveInPlace(Board, placed, FCascadeRules());
+   }
+
+   // Generate pieces landing on columns that have room for them
+   void BuildPieces(const FColumnsBoard& Board, FRandomStream& Stream, TArray<FBenchPiece>& OutPieces)
+   {
+      TArray<int32> open_column;
+      for (int32 col = 0; col < Board.GetColumnCount(); col++)
+      {
+         if (Board.GetFloor(col) + 3 <= Board.GetRowCount())
+            open_column.Add(col);
+      }
+
+      OutPieces.Reset();
+      if (open_column.Num() == 0)
+         return;
+
+      for (int32 i = 0; i < BenchPieceCount; i++)
+      {
+         FBenchPiece& piece = OutPieces[OutPieces.AddDefaulted()];
+         piece.Column = open_column[Stream.RandRange(0, open_column.Num() - 1)];
+         for (int32& type_id : piece.Types)
+         {
+            type_id = Stream.RandRange(0, BenchTypeCount - 1);
+         }
+      }
+   }
+
+   // Remove a piece placed by FColumnsBoard::PlacePiece(), restoring the floor of its column
+   void RemovePiece(FColumnsBoard& Board, const FBenchPiece& Piece, const TArray<int32>& Landed)
+   {
+      for (int32 cell_index : Landed)
+      {
+         Board.ClearCell(cell_index);
+      }
+      Board.SetFloor(Piece.Column, Board.GetFloor(Piece.Column) - Landed.Num());
+   }
+
+
+   void RunBoardBenchmarks(FBenchReport& Report, int32 Columns, int32 Rows, float Fill, int32 Seed, double MinTime)
+   {
+      FRandomStream stream(Seed);
+
+      FColumnsBoard board;
+      BuildBoard(board, Columns, Rows, Fill, stream);
+
+      TArray<FBenchPiece> pieces;
+      BuildPieces(board, stream, pieces);
+
+      const int32 cell_count = board.GetCellCount();
+      double seconds = 0.0;
+      int64 ops = 0;
+
+      FMatchedCellSet matched;
+      matched.Init(cell_count);
+
+      // The directional walkers (GetLeftMatch() and friends), from every occupied cell in all 8 directions
+      {
+         TArray<int32> occupied;
+         for (int32 cell_index = 0; cell_index < cell_count; cell_index++)
+         {
+            if (!board.IsEmpty(cell_index))
+               occupied.Add(cell_index);
+         }
+
+         if (occupied.Num() > 0)
+         {
+            static const int32 steps[8][2] = { { -1, 0 }, { 1, 0 }, { 0, 1 }, { 0, -1 }, { -1, 1 }, { 1, 1 }, { -1, -1 }, { 1, -1 } };
+
+            ops = Measure(MinTime, occupied.Num() * 8, seconds, [&]()
+            {
+               int64 counted = 0;
+               for (int32 cell_index : occupied)
+               {
+                  const int32 column = board.GetColumn(cell_index);
+                  const int32 row = board.GetRow(cell_index);
+                  const int32 type_id = board.GetType(cell_index);
+                  for (const int32* step : steps)
+                  {
+                     counted += board.CountRun(column, row, step[0], step[1], type_id);
+                  }
+               }
+               GBenchSink += counted;
+            });
+            Report.Add(TEXT("CountRun"), TEXT("-"), Columns, Rows, Fill, ops, seconds, 1);
+         }
+      }
+
+      // Full board match scan with every kernel the CPU supports. The bitboard is kept out of the kernel timings
+      // and measured on its own, at every size, so the crossover with the scalar kernel can be seen
+      board.SetBitboardMinColumns(MAX_int32);
+      for (int32 k = 0; k <= (int32)FRunLengthKernel::GetBestSupported(); k++)
+      {
+         const ERunKernel kernel = (ERunKernel)k;
+         board.SetMatchKernel(kernel);
+
+         ops = Measure(MinTime, 1, seconds, [&]()
+         {
+            matched.Reset();
+            GBenchSink += board.FindMatches(matched);
+         });
+         Report.Add(TEXT("FindMatches"), FRunLengthKernel::GetName(kernel), Columns, Rows, Fill, ops, seconds, cell_count);
+      }
+
+      board.SetMatchKernel(ERunKernel::Scalar);
+      board.SetBitboardMinColumns(0);
+      ops = Measure(MinTime, 1, seconds, [&]()
+      {
+         matched.Reset();
+         GBenchSink += board.FindMatches(matched);
+      });
+      Report.Add(TEXT("FindMatches"), TEXT("Bitboard"), Columns, Rows, Fill, ops, seconds, cell_count);
+
+      board.SetBitboardMinColumns(FColumnsBoard::DefaultBitboardMinColumns);
+      board.SetMatchKernel(FRunLengthKernel::GetBestSupported());
+
+      // Column floor rescan (CheckGridFloorLevels())
+      ops = Measure(MinTime, 1, seconds, [&]()
+      {
+         board.RefreshFloors();
+         GBenchSink += board.GetFloor(0);
+      });
+      Report.Add(TEXT("RefreshFloors"), TEXT("-"), Columns, Rows, Fill, ops, seconds, cell_count);
+
+      if (pieces.Num() > 0)
+      {
+         TArray<int32> landed;
+         int32 piece_index = 0;
+
+         // Match check right after a piece lands (CheckMatchingBlocks()). Placing and removing the piece is included
+         ops = Measure(MinTime, 1, seconds, [&]()
+         {
+            const FBenchPiece& piece = pieces[piece_index];
+            piece_index = (piece_index + 1) % pieces.Num();
+
+            landed.Reset();
+            board.PlacePiece(piece.Column, piece.Types, 3, landed);
+            matched.Reset();
+            GBenchSink += board.FindMatchesAfterChange(landed, matched);
+            RemovePiece(board, piece, landed);
+         });
+         Report.Add(TEXT("CheckAfterLanding"), TEXT("-"), Columns, Rows, Fill, ops, seconds, 3);
+
+         // The entire chain of matches and compaction (StateCheckMatch to StateCheckPlayfield) triggered by a piece.
+         // Resolving on a copy of the board is part of the cost
+         FCascadeResolver resolver;
+         FCascadeRules rules;
+         ops = Measure(MinTime, 1, seconds, [&]()
+         {
+            const FBenchPiece& piece = pieces[piece_index];
+            piece_index = (piece_index + 1) % pieces.Num();
+
+            landed.Reset();
+            board.PlacePiece(piece.Column, piece.Types, 3, landed);
+            resolver.Resolve(board, landed, rules);
+            GBenchSink += resolver.GetTotalScore();
+            RemovePiece(board, piece, landed);
+         });
+         Report.Add(TEXT("ResolveCascade"), TEXT("-"), Columns, Rows, Fill, ops, seconds, cell_count);
+      }
+   }
+
+   void RunPickerBenchmark(FBenchReport& Report, int32 Seed, double MinTime)
+   {
+      // The regular theme size and a large one, which should cost the same per pick
+      const int32 type_counts[] = { BenchTypeCount, 64 };
+      for (int32 type_count : type_counts)
+      {
+         TArray<float> weights;
+         for (int32 i = 0; i < type_count; i++)
+         {
+            weights.Add(1.0f + (i % BenchTypeCount) * 0.5f);
+         }
+
+         FBlockPicker picker;
+         picker.SetWeights(weights);
+
+         FRandomStream stream(Seed);
+         const int32 picks_per_call = 1024;
+         double seconds = 0.0;
+         const int64 ops = Measure(MinTime, picks_per_call, seconds, [&]()
+         {
+            int64 sum = 0;
+            for (int32 i = 0; i < picks_per_call; i++)
+            {
+               sum += picker.Pick(stream);
+            }
+            GBenchSink += sum;
+         });
+         Report.Add(TEXT("PickBlock"), *FString::Printf(TEXT("%d types"), type_count), 0, 0, 0.0f, ops, seconds, 1);
+      }
+   }
+
+   // Collecting the cells of a single match wave, the way the directional walkers emit them: every cell of a run is
+   // added, so cells where runs cross come more than once. Compares the bitmap backed set against TArray::AddUnique(),
+   // both ending with the ascending order handed to OnBlockMatched
+   void RunMatchedSetBenchmark(FBenchReport& Report, int32 Columns, int32 Rows, int32 Seed, double MinTime)
+   {
+      const int32 cell_count = Columns * Rows;
+      const int32 cleared_counts[] = { 30, 100, 300, 1000 };
+
+      FRandomStream stream(Seed);
+      for (int32 cleared : cleared_counts)
+      {
+         if (cleared > cell_count)
+            continue;
+
+         // Random distinct cells, roughly a third of them reported by two or three crossing runs
+         TArray<int32> cells;
+         for (int32 cell_index = 0; cell_index < cell_count; cell_index++)
+         {
+            cells.Add(cell_index);
+         }
+         for (int32 i = 0; i < cleared; i++)
+         {
+            cells.Swap(i, stream.RandRange(i, cell_count - 1));
+         }
+
+         TArray<int32> emitted;
+         for (int32 i = 0; i < cleared; i++)
+         {
+            const int32 repeat = stream.FRand() < 0.33f ? stream.RandRange(2, 3) : 1;
+            for (int32 r = 0; r < repeat; r++)
+            {
+               emitted.Add(cells[i]);
+            }
+         }
+         for (int32 i = 0; i < emitted.Num(); i++)
+         {
+            emitted.Swap(i, stream.RandRange(i, emitted.Num() - 1));
+         }
+
+         const float fill = (float)cleared / (float)cell_count;
+         const FString variant = FString::Printf(TEXT("%d cells"), cleared);
+         double seconds = 0.0;
+
+         TArray<int32> unique_cells;
+         int64 ops = Measure(MinTime, 1, seconds, [&]()
+         {
+            unique_cells.Reset();
+            for (int32 cell_index : emitted)
+            {
+               unique_cells.AddUnique(cell_index);
+            }
+            unique_cells.Sort();
+            GBenchSink += unique_cells.Num();
+         });
+         Report.Add(TEXT("CollectAddUnique"), *variant, Columns, Rows, fill, ops, seconds, emitted.Num());
+
+         FMatchedCellSet matched;
+         matched.Init(cell_count);
+         ops = Measure(MinTime, 1, seconds, [&]()
+         {
+            matched.Reset();
+            for (int32 cell_index : emitted)
+            {
+               matched.Add(cell_index);
+            }
+            matched.Sort();
+            GBenchSink += matched.Num();
+         });
+         Report.Add(TEXT("CollectCellSet"), *variant, Columns, Rows, fill, ops, seconds, emitted.Num());
+      }
+   }
+
+   // Tell if both sets hold the same cells in the same order
+   bool SameCells(const FMatchedCellSet& A, const FMatchedCellSet& B)
+   {
+      if (A.Num() != B.Num())
+         return false;
+
+      for (int32 i = 0; i < A.Num(); i++)
+      {
+         if (A.GetCells()[i] != B.GetCells()[i])
+            return false;
+      }
+      return true;
+   }
+
+   // Check every kernel the CPU supports and the bitboard against walking from every cell with CountRun(), on
+   // random boards of random sizes and rules. The board and sets are reused so scratch memory sees size changes.
+   // The bitboard is maintained through random overwrites and removals before it's scanned, rather than rebuilt.
+   // Returns the amount of mismatching scans
+   int32 VerifyMatchPaths(int32 Seed, int32 BoardCount)
+   {
+      static const EMatchDirection directions[] = { EMatchDirection::All, EMatchDirection::Orthogonal, EMatchDirection::Horizontal,
+         EMatchDirection::Vertical, EMatchDirection::Diagonal, EMatchDirection::Vertical | EMatchDirection::DiagonalUpLeft };
+
+      FRandomStream stream(Seed);
+      FColumnsBoard board;
+      FMatchedCellSet expected;
+      FMatchedCellSet matched;
+      TArray<int32> all_cells;
+
+      int32 failures = 0;
+      for (int32 b = 0; b < BoardCount; b++)
+      {
+         const int32 columns = stream.RandRange(1, 140);
+         const int32 rows = stream.RandRange(1, 70);
+         const int32 run_size = stream.RandRange(1, 6);
+         const EMatchDirection match_directions = directions[stream.RandRange(0, ARRAY_COUNT(directions) - 1)];
+         const int32 type_count = stream.RandRange(1, BenchTypeCount);
+         const float fill = stream.FRandRange(0.2f, 1.0f);
+
+         // Start on the bitboard path so it's updated by SetCell() and ClearCell() rather than built at once
+         board.SetMatchKernel(ERunKernel::Scalar);
+         board.SetBitboardMinColumns(0);
+         board.Init(columns, rows);
+         board.SetMatchRules(FMatchRules(run_size, match_directions));
+
+         const int32 cell_count = board.GetCellCount();
+         for (int32 cell_index = 0; cell_index < cell_count; cell_index++)
+         {
+            if (stream.FRand() < fill)
+               board.SetCell(cell_index, stream.RandRange(0, type_count - 1));
+         }
+         for (int32 i = 0; i < cell_count / 4; i++)
+         {
+            const int32 cell_index = stream.RandRange(0, cell_count - 1);
+            if (stream.FRand() < 0.5f)
+               board.ClearCell(cell_index);
+            else
+               board.SetCell(cell_index, stream.RandRange(0, type_count - 1));
+         }
+
+         all_cells.Reset();
+         for (int32 cell_index = 0; cell_index < cell_count; cell_index++)
+         {
+            all_cells.Add(cell_index);
+         }
+
+         expected.Init(cell_count);
+         board.FindMatchesAround(all_cells, expected);
+         expected.Sort();
+
+         matched.Init(cell_count);
+         board.FindMatches(matched);
+         if (!SameCells(expected, matched))
+         {
+            UE_LOG(LogColumnsBench, Error, TEXT("Bitboard mismatch on board %d (%dx%d, run of %d, directions %d): %d cells, expected %d"), b, columns, rows, run_size, (int32)match_directions, matched.Num(), expected.Num());
+            failures++;
+         }
+
+         board.SetBitboardMinColumns(MAX_int32);
+         for (int32 k = 0; k <= (int32)FRunLengthKernel::GetBestSupported(); k++)
+         {
+            const ERunKernel kernel = (ERunKernel)k;
+            board.SetMatchKernel(kernel);
+
+            matched.Reset();
+            board.FindMatches(matched);
+            if (!SameCells(expected, matched))
+            {
+               UE_LOG(LogColumnsBench, Error, TEXT("%s mismatch on board %d (%dx%d, run of %d, directions %d): %d cells, expected %d"), FRunLengthKernel::GetName(kernel), b, columns, rows, run_size, (int32)match_directions, matched.Num(), expected.Num());
+               failures++;
+            }
+         }
+      }
+
+      return failures;
+   }
+
+   // Per frame cost of a repositioning wave moving half of the grid. Durations are long enough for no tween to finish
+   void RunTweenBenchmark(FBenchReport& Report, int32 Columns, int32 Rows, double MinTime)
+   {
+      const int32 tween_count = (Columns * Rows) / 2;
+
+      FTweenScheduler tween;
+      tween.Reserve(tween_count);
+      for (int32 i = 0; i < tween_count; i++)
+      {
+         const FVector start((float)(i % Columns), 0.0f, (float)Rows);
+         tween.Add(i, start, FVector(start.X, 0.0f, 0.0f), 1.0e6f);
+      }
+
+      double seconds = 0.0;
+      const int64 ops = Measure(MinTime, tween_count, seconds, [&]()
+      {
+         tween.Update(1.0f / 60.0f);
+         GBenchSink += tween.GetValues().Num();
+      });
+      Report.Add(TEXT("TweenUpdate"), TEXT("-"), Columns, Rows, 0.5f, ops, seconds, 1);
+   }
+}
+
+
+INT32_MAIN_INT32_ARGC_TCHAR_ARGV()
+{
+   GEngineLoop.PreInit(ArgC, ArgV);
+
+   const TCHAR* cmd_line = FCommandLine::Get();
+
+   int32 seed = 1234;
+   FParse::Value(cmd_line, TEXT("-seed="), seed);
+
+   float min_time = 0.25f;
+   FParse::Value(cmd_line, TEXT("-mintime="), min_time);
+
+   FString csv_path;
+   FParse::Value(cmd_line, TEXT("-csv="), csv_path);
+
+   static const int32 sizes[][2] = { { 9, 16 }, { 16, 32 }, { 32, 64 }, { 64, 128 }, { 128, 256 } };
+   static const float fills[] = { 0.25f, 0.5f, 0.75f };
+
+   UE_LOG(LogColumnsBench, Display, TEXT("Seed %d, best kernel %s"), seed, FRunLengthKernel::GetName(FRunLengthKernel::GetBestSupported()));
+
+   if (FParse::Param(cmd_line, TEXT("verify")))
+   {
+      int32 board_count = 4000;
+      FParse::Value(cmd_line, TEXT("-boards="), board_count);
+
+      const int32 failures = VerifyMatchPaths(seed, board_count);
+      if (failures > 0)
+      {
+         UE_LOG(LogColumnsBench, Error, TEXT("%d mismatching scans"), failures);
+      }
+      else
+      {
+         UE_LOG(LogColumnsBench, Display, TEXT("All match paths agree with the reference on %d boards"), board_count);
+      }
+
+      FEngineLoop::AppPreExit();
+      FEngineLoop::AppExit();
+      return failures > 0 ? 1 : 0;
+   }
+
+   FBenchReport report;
+   int32 board_seed = seed;
+   for (const int32* size : sizes)
+   {
+      for (float fill : fills)
+      {
+         // Each board gets its own seed so adding sizes doesn't change the others
+         RunBoardBenchmarks(report, size[0], size[1], fill, board_seed++, min_time);
+      }
+      RunMatchedSetBenchmark(report, size[0], size[1], board_seed++, min_time);
+      RunTweenBenchmark(report, size[0], size[1], min_time);
+   }
+   RunPickerBenchmark(report, seed, min_time);
+
+   int32 exit_code = 0;
+   if (!csv_path.IsEmpty())
+   {
+      if (report.Save(csv_path))
+      {
+         UE_LOG(LogColumnsBench, Display, TEXT("Results written into %s"), *csv_path);
+      }
+      else
+      {
+         UE_LOG(LogColumnsBench, Error, TEXT("Unable to write %s"), *csv_path);
+         exit_code = 1;
+      }
+   }
+
+   FEngineLoop::AppPreExit();
+   FEngineLoop::AppExit();
+   return exit_code;
+}
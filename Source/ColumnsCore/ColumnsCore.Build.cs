@@ -0,0 +1,15 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+using UnrealBuildTool;
+
+// Gameplay rules of the game (board, matching, cascades and block picking) as plain C++, depending only on Core
+// so it can be used by tools and headless programs without bringing the engine along
+public class ColumnsCore : ModuleRules
+{
+	public ColumnsCore(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PublicDependencyModuleNames.AddRange(new string[] { "Core" });
+	}
+}
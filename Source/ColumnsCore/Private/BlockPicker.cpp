@@ -0,0 +1,82 @@
+/**
+ * This source code is provided as reference/companion material for the uColumnsTutorial
+ * that can be freely found at http://www.kehomsforge.com and should not be commercialized
+ * in any form. It should remain free!
+ *
+ * By Yuri Sarudiansky
+ */
+
+#include "BlockPicker.h"
+
+
+void FBlockPicker::SetWeights(const TArray<float>& Weights)
+{
+   mWeight = Weights;
+
+   mWeightSum = 0.0f;
+   for (float weight : mWeight)
+   {
+      mWeightSum += FMath::Max(weight, 0.0f);
+   }
+
+   const int32 count = mWeight.Num();
+   mProbability.SetNum(count, false);
+   mAlias.SetNum(count, false);
+
+   // Scale the weights so the average is 1, splitting them into the ones below and above the average. Without any
+   // weight every type is equally likely
+   TArray<int32> small;
+   TArray<int32> large;
+   small.Reserve(count);
+   large.Reserve(count);
+   for (int32 i = 0; i < count; i++)
+   {
+      mProbability[i] = mWeightSum > 0.0f ? FMath::Max(mWeight[i], 0.0f) * count / mWeightSum : 1.0f;
+      mAlias[i] = i;
+      if (mProbability[i] < 1.0f)
+      {
+         small.Add(i);
+      }
+      else
+      {
+         large.Add(i);
+      }
+   }
+
+   // Each column below the average is filled up by the excess of one above it
+   while (small.Num() > 0 && large.Num() > 0)
+   {
+      const int32 less = small.Pop(false);
+      const int32 more = large.Last();
+
+      mAlias[less] = more;
+      mProbability[more] -= 1.0f - mProbability[less];
+      if (mProbability[more] < 1.0f)
+      {
+         large.Pop(false);
+         small.Add(more);
+      }
+   }
+
+   // Whatever is left is only off the average because of floating point error
+   for (int32 i : small)
+   {
+      mProbability[i] = 1.0f;
+   }
+   for (int32 i : large)
+   {
+      mProbability[i] = 1.0f;
+   }
+}
+
+int32 FBlockPicker::PickFraction(float Fraction) const
+{
+   const int32 count = mProbability.Num();
+   if (count == 0)
+      return -1;
+
+   // The integer part of the scaled fraction selects the column, the rest decides between the type and its alias
+   const float scaled = FMath::Clamp(Fraction, 0.0f, 1.0f) * count;
+   const int32 column = FMath::Min((int32)scaled, count - 1);
+   return (scaled - column) < mProbability[column] ? column : mAlias[column];
+}
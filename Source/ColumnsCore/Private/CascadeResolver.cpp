@@ -0,0 +1,139 @@
+/**
+ * This source code is provided as reference/companion material for the uColumnsTutorial
+ * that can be freely found at http://www.kehomsforge.com and should not be commercialized
+ * in any form. It should remain free!
+ *
+ * By Yuri Sarudiansky
+ */
+
+#include "CascadeResolver.h"
+
+
+void FCascadeResolver::Resolve(const FColumnsBoard& Board, const TArray<int32>& LandedCells, const FCascadeRules& Rules)
+{
+   // Copying into the existing board reuses its memory
+   mBoard = Board;
+   ResolveInPlace(mBoard, LandedCells, Rules);
+}
+
+void FCascadeResolver::ResolveInPlace(FColumnsBoard& Board, const TArray<int32>& LandedCells, const FCascadeRules& Rules)
+{
+   // Make sure the scratch data matches the board dimensions
+   if (mColumnLowestRemoved.Num() != Board.GetColumnCount() || mMatchedCellCount != Board.GetCellCount())
+   {
+      mMatched.Init(Board.GetCellCount());
+      mMatchedCellCount = Board.GetCellCount();
+      mColumnLowestRemoved.Init(-1, Board.GetColumnCount());
+      mDirtyColumn.Empty(Board.GetColumnCount());
+   }
+
+   mWaveCount = 0;
+   mTotalScore = 0;
+   mFinalMultiplier = Rules.InitialMultiplier;
+
+   // A new run can only be formed if at least one block has been placed. Every run that existed before that has
+   // already been removed, so any run found on the board goes through a landed block
+   if (LandedCells.Num() == 0)
+      return;
+
+   // Cells that received blocks, the landed ones for the first wave then the ones blocks have fallen into
+   mChanged = LandedCells;
+
+   while (true)
+   {
+      mMatched.Reset();
+      if (!Board.FindMatchesAfterChange(mChanged, mMatched))
+         break;
+
+      // Reuse a previously allocated wave if possible
+      if (mWaveCount == mWaves.Num())
+      {
+         mWaves.AddDefaulted();
+      }
+      FCascadeWave& wave = mWaves[mWaveCount++];
+
+      wave.MatchedCells = mMatched.GetCells();
+      wave.Moves.Reset();
+      wave.Floors.Reset();
+      wave.Multiplier = mFinalMultiplier;
+      wave.Score = wave.MatchedCells.Num() * Rules.ScorePerBlock * wave.Multiplier;
+
+      mTotalScore += wave.Score;
+      mFinalMultiplier += Rules.MultiplierDelta;
+
+      Collapse(Board, wave);
+
+      // If nothing has fallen then the board didn't change in a way that allows new runs
+      if (wave.Moves.Num() == 0)
+         break;
+
+      mChanged.Reset();
+      for (const FCascadeMove& move : wave.Moves)
+      {
+         mChanged.Add(move.ToCell);
+      }
+   }
+}
+
+
+void FCascadeResolver::Collapse(FColumnsBoard& Board, FCascadeWave& Wave)
+{
+   for (int32 cell_index : Wave.MatchedCells)
+   {
+      Board.ClearCell(cell_index);
+
+      // Record the affected column and the lowest row that became empty in it
+      const int32 column = Board.GetColumn(cell_index);
+      const int32 row = Board.GetRow(cell_index);
+      if (mColumnLowestRemoved[column] < 0)
+      {
+         mColumnLowestRemoved[column] = row;
+         mDirtyColumn.Add(column);
+      }
+      else
+      {
+         mColumnLowestRemoved[column] = FMath::Min(mColumnLowestRemoved[column], row);
+      }
+   }
+
+   const int32 column_count = Board.GetColumnCount();
+
+   // Columns that haven't lost any block can't have gaps, so only the dirty ones must be compacted
+   for (int32 col : mDirtyColumn)
+   {
+      // Everything below the lowest removed block is untouched, so the compaction can start from there
+      int32 new_floor = mColumnLowestRemoved[col];
+      int32 read_index = Board.GetCellIndex(col, new_floor);
+      const int32 old_floor = Board.GetFloor(col);
+
+      for (int32 row = new_floor; row < old_floor; row++)
+      {
+         if (!Board.IsEmpty(read_index))
+         {
+            const int32 gap_level = row - new_floor;
+
+            if (gap_level > 0)
+            {
+               // The block must fall into the gap
+               const int32 dest_index = Board.GetCellIndex(col, new_floor);
+               Board.SetCell(dest_index, Board.GetType(read_index));
+               Board.ClearCell(read_index);
+
+               Wave.Moves.Add(FCascadeMove(read_index, dest_index, gap_level));
+            }
+
+            new_floor++;
+         }
+
+         // Move the reading index into the row above
+         read_index += column_count;
+      }
+
+      Board.SetFloor(col, new_floor);
+      Wave.Floors.Add(FCascadeFloor(col, new_floor));
+
+      // And mark the column as clean
+      mColumnLowestRemoved[col] = -1;
+   }
+   mDirtyColumn.Reset();
+}
@@ -0,0 +1,265 @@
+/**
+ * This source code is provided as reference/companion material for the uColumnsTutorial
+ * that can be freely found at http://www.kehomsforge.com and should not be commercialized
+ * in any form. It should remain free!
+ *
+ * By Yuri Sarudiansky
+ */
+
+#include "ColumnsBoard.h"
+
+
+void FColumnsBoard::Init(int32 ColumnCount, int32 RowCount)
+{
+   mColumnCount = ColumnCount;
+   mRowCount = RowCount;
+
+   const int32 cell_count = ColumnCount * RowCount;
+
+   mTypePlane.Empty(cell_count);
+   mTypePlane.AddUninitialized(cell_count);
+
+   mFloor.Empty(ColumnCount);
+   mFloor.AddZeroed(ColumnCount);
+
+   Reset();
+
+   // The dimensions changed, so the bitboard has to be rebuilt
+   mUseBitboard = false;
+   RefreshMatchPath();
+}
+
+void FColumnsBoard::Reset()
+{
+   if (mTypePlane.Num() > 0)
+   {
+      FMemory::Memset(mTypePlane.GetData(), (uint8)EmptyCell, mTypePlane.Num());
+   }
+
+   for (int32 col = 0; col < mFloor.Num(); col++)
+   {
+      mFloor[col] = 0;
+   }
+
+   if (mUseBitboard)
+   {
+      mBitboard.Reset();
+   }
+}
+
+void FColumnsBoard::RefreshFloors()
+{
+   for (int32 col = 0; col < mColumnCount; col++)
+   {
+      // Assume the column is empty
+      mFloor[col] = 0;
+
+      // Then walk down from the top until a block is found
+      int32 read_index = GetCellIndex(col, mRowCount - 1);
+      for (int32 row = mRowCount - 1; row >= 0; row--)
+      {
+         if (mTypePlane[read_index] != EmptyCell)
+         {
+            mFloor[col] = row + 1;
+            break;
+         }
+         read_index -= mColumnCount;
+      }
+   }
+}
+
+void FColumnsBoard::SetCell(int32 CellIndex, int32 TypeID)
+{
+   const int32 column = GetColumn(CellIndex);
+   const int32 row = GetRow(CellIndex);
+
+   if (mUseBitboard)
+   {
+      // Whatever was in the cell leaves its plane
+      mBitboard.ClearCell(column, row, mTypePlane[CellIndex]);
+      mBitboard.SetCell(column, row, TypeID);
+   }
+
+   // Type IDs are stored as bytes, which is plenty for any theme
+   mTypePlane[CellIndex] = (int8)TypeID;
+
+   // The floor of the column is right above its highest block
+   mFloor[column] = FMath::Max(mFloor[column], row + 1);
+}
+
+void FColumnsBoard::ClearCell(int32 CellIndex)
+{
+   if (mUseBitboard)
+   {
+      mBitboard.ClearCell(GetColumn(CellIndex), GetRow(CellIndex), mTypePlane[CellIndex]);
+   }
+
+   mTypePlane[CellIndex] = EmptyCell;
+}
+
+bool FColumnsBoard::PlacePiece(int32 Column, const int32* Types, int32 Count, TArray<int32>& OutLanded)
+{
+   if (Column < 0 || Column >= mColumnCount || mFloor[Column] + Count > mRowCount)
+      return false;
+
+   for (int32 i = 0; i < Count; i++)
+   {
+      // Each placed block raises the floor, so the next one goes right above it
+      const int32 cell_index = GetCellIndex(Column, mFloor[Column]);
+      SetCell(cell_index, Types[i]);
+      OutLanded.Add(cell_index);
+   }
+
+   return true;
+}
+
+int32 FColumnsBoard::CountRun(int32 Column, int32 Row, int32 ColumnStep, int32 RowStep, int32 TypeID) const
+{
+   if (TypeID == EmptyCell)
+      return 0;
+
+   int32 current_column = Column + ColumnStep;
+   int32 current_row = Row + RowStep;
+   int32 data_index = GetCellIndex(current_column, current_row);
+   if (data_index < 0)
+      return 0;
+
+   // Shortcut to "walk" one step in the type plane
+   const int32 index_step = (RowStep * mColumnCount) + ColumnStep;
+
+   int32 counted = 0;
+   while (current_column >= 0 && current_column < mColumnCount && current_row >= 0 && current_row < mRowCount)
+   {
+      // If cell is empty or if the block is of different type, stop the counting
+      if (mTypePlane[data_index] != TypeID)
+         return counted;
+
+      counted++;
+      data_index += index_step;
+      current_column += ColumnStep;
+      current_row += RowStep;
+   }
+   return counted;
+}
+
+namespace
+{
+   struct FAxis
+   {
+      EMatchDirection Direction;
+      int32 ColumnStep;
+      int32 RowStep;
+   };
+
+   const FAxis MatchAxes[] = {
+      { EMatchDirection::Horizontal, 1, 0 },
+      { EMatchDirection::Vertical, 0, 1 },
+      { EMatchDirection::DiagonalUpRight, 1, 1 },
+      { EMatchDirection::DiagonalUpLeft, -1, 1 },
+   };
+}
+
+bool FColumnsBoard::FormsRun(int32 Column, int32 Row, int32 TypeID) const
+{
+   const FMatchRules& rules = GetMatchRules();
+
+   for (const FAxis& axis : MatchAxes)
+   {
+      if (!EnumHasAnyFlags(rules.Directions, axis.Direction))
+         continue;
+
+      const int32 forward = CountRun(Column, Row, axis.ColumnStep, axis.RowStep, TypeID);
+      const int32 backward = CountRun(Column, Row, -axis.ColumnStep, -axis.RowStep, TypeID);
+
+      if (forward + backward + 1 >= rules.RunSize)
+         return true;
+   }
+   return false;
+}
+
+bool FColumnsBoard::FindMatches(FMatchedCellSet& OutMatched) const
+{
+   if (mUseBitboard)
+      return mBitboard.FindMatches(GetMatchRules(), OutMatched);
+
+   return mMatchKernel.FindMatches(mTypePlane.GetData(), mColumnCount, mRowCount, OutMatched);
+}
+
+bool FColumnsBoard::FindMatchesAround(const TArray<int32>& Cells, FMatchedCellSet& OutMatched) const
+{
+   const FMatchRules& rules = GetMatchRules();
+   const int32 run_size = FMath::Max(rules.RunSize, 1);
+   bool found = false;
+
+   for (int32 cell_index : Cells)
+   {
+      const int32 type_id = mTypePlane[cell_index];
+      if (type_id == EmptyCell)
+         continue;
+
+      const int32 column = GetColumn(cell_index);
+      const int32 row = GetRow(cell_index);
+
+      for (const FAxis& axis : MatchAxes)
+      {
+         if (!EnumHasAnyFlags(rules.Directions, axis.Direction))
+            continue;
+
+         const int32 backward = CountRun(column, row, -axis.ColumnStep, -axis.RowStep, type_id);
+         const int32 forward = CountRun(column, row, axis.ColumnStep, axis.RowStep, type_id);
+
+         if (backward + forward + 1 >= run_size)
+         {
+            // Add the entire run, from its first to its last cell
+            const int32 index_step = (axis.RowStep * mColumnCount) + axis.ColumnStep;
+            int32 run_index = cell_index - (backward * index_step);
+            for (int32 i = -backward; i <= forward; i++)
+            {
+               OutMatched.Add(run_index);
+               run_index += index_step;
+            }
+            found = true;
+         }
+      }
+   }
+
+   return found;
+}
+
+bool FColumnsBoard::FindMatchesAfterChange(const TArray<int32>& Changed, FMatchedCellSet& OutMatched) const
+{
+   if (Changed.Num() == 0)
+      return false;
+
+   if (Changed.Num() > mLocalMatchBase + GetCellCount() * mLocalMatchDensity)
+      return FindMatches(OutMatched);
+
+   if (!FindMatchesAround(Changed, OutMatched))
+      return false;
+
+   // The full sweep gives ascending indices, so do the same here
+   OutMatched.Sort();
+   return true;
+}
+
+void FColumnsBoard::RefreshMatchPath()
+{
+   const bool use_bitboard = mMatchKernel.GetKernel() == ERunKernel::Scalar && mColumnCount >= mBitboardMinColumns;
+   if (use_bitboard == mUseBitboard)
+      return;
+
+   mUseBitboard = use_bitboard;
+   if (!use_bitboard)
+   {
+      // Release the planes, they are not needed by the byte plane kernels
+      mBitboard = FMatchBitboard();
+      return;
+   }
+
+   mBitboard.Init(mColumnCount, mRowCount);
+   for (int32 cell_index = 0; cell_index < mTypePlane.Num(); cell_index++)
+   {
+      if (mTypePlane[cell_index] != EmptyCell)
+         mBitboard.SetCell(GetColumn(cell_index), GetRow(cell_index), mTypePlane[cell_index]);
+   }
+}
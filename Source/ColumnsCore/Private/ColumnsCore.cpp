@@ -0,0 +1,12 @@
+/**
+ * This source code is provided as reference/companion material for the uColumnsTutorial
+ * that can be freely found at http://www.kehomsforge.com and should not be commercialized
+ * in any form. It should remain free!
+ *
+ * By Yuri Sarudiansky
+ */
+
+#include "CoreMinimal.h"
+#include "Modules/ModuleManager.h"
+
+IMPLEMENT_MODULE(FDefaultModuleImpl, ColumnsCore);
@@ -0,0 +1,293 @@
+/**
+ * This source code is provided as reference/companion material for the uColumnsTutorial
+ * that can be freely found at http://www.kehomsforge.com and should not be commercialized
+ * in any form. It should remain free!
+ *
+ * By Yuri Sarudiansky
+ */
+
+#include "MatchBitboard.h"
+
+
+// Index of the lowest set bit of a non zero value
+static FORCEINLINE int32 LowestBitIndex(uint64 Value)
+{
+   const uint32 low = (uint32)Value;
+   return low ? FMath::CountTrailingZeros(low) : 32 + FMath::CountTrailingZeros((uint32)(Value >> 32));
+}
+
+// AND the Other row into the Acc row, returning true if anything remains set
+static FORCEINLINE bool AndInto(uint64* Acc, const uint64* Other, int32 WordCount)
+{
+   uint64 any = 0;
+   for (int32 w = 0; w < WordCount; w++)
+   {
+      Acc[w] &= Other[w];
+      any |= Acc[w];
+   }
+   return any != 0;
+}
+
+// OR the Other row into the Acc row
+static FORCEINLINE void OrInto(uint64* Acc, const uint64* Other, int32 WordCount)
+{
+   for (int32 w = 0; w < WordCount; w++)
+   {
+      Acc[w] |= Other[w];
+   }
+}
+
+
+
+void FMatchBitboard::Init(int32 ColumnCount, int32 RowCount)
+{
+   mColumnCount = ColumnCount;
+   mRowCount = RowCount;
+   mWordsPerRow = (ColumnCount + 63) / 64;
+
+   // Planes will be allocated as soon as type IDs are set
+   mPlane.Empty();
+   mPlaneCount.Empty();
+
+   mMask.SetNumUninitialized(mRowCount * mWordsPerRow);
+   mScratch.SetNumUninitialized(mWordsPerRow * 2);
+}
+
+void FMatchBitboard::Reset()
+{
+   if (mPlane.Num() > 0)
+   {
+      FMemory::Memzero(mPlane.GetData(), mPlane.Num() * sizeof(uint64));
+   }
+
+   for (int32 i = 0; i < mPlaneCount.Num(); i++)
+   {
+      mPlaneCount[i] = 0;
+   }
+}
+
+void FMatchBitboard::SetCell(int32 Column, int32 Row, int32 TypeID)
+{
+   if (TypeID < 0)
+      return;
+
+   if (TypeID >= mPlaneCount.Num())
+   {
+      // Allocate the planes up to the requested type
+      const int32 new_planes = TypeID + 1 - mPlaneCount.Num();
+      mPlane.AddZeroed(new_planes * mRowCount * mWordsPerRow);
+      mPlaneCount.AddZeroed(new_planes);
+   }
+
+   uint64& word = GetRow(TypeID, Row)[Column / 64];
+   const uint64 bit = uint64(1) << (Column % 64);
+   if (!(word & bit))
+   {
+      word |= bit;
+      mPlaneCount[TypeID]++;
+   }
+}
+
+void FMatchBitboard::ClearCell(int32 Column, int32 Row, int32 TypeID)
+{
+   if (TypeID < 0 || TypeID >= mPlaneCount.Num())
+      return;
+
+   uint64& word = GetRow(TypeID, Row)[Column / 64];
+   const uint64 bit = uint64(1) << (Column % 64);
+   if (word & bit)
+   {
+      word &= ~bit;
+      mPlaneCount[TypeID]--;
+   }
+}
+
+bool FMatchBitboard::FindMatches(const FMatchRules& Rules, FMatchedCellSet& OutMatched)
+{
+   // A run must hold at least one block
+   const int32 run_size = FMath::Max(Rules.RunSize, 1);
+
+   if (mMask.Num() > 0)
+   {
+      FMemory::Memzero(mMask.GetData(), mMask.Num() * sizeof(uint64));
+   }
+
+   bool found = false;
+   for (int32 type_id = 0; type_id < mPlaneCount.Num(); type_id++)
+   {
+      // If there aren't enough blocks of this type there is no way a run can be formed
+      if (mPlaneCount[type_id] >= run_size)
+      {
+         found |= FindTypeMatches(type_id, run_size, Rules.Directions);
+      }
+   }
+
+   if (!found)
+      return false;
+
+   // Emit the cell indices. Walking the mask in memory order results in ascending indices
+   for (int32 row = 0; row < mRowCount; row++)
+   {
+      const uint64* mask_row = &mMask[row * mWordsPerRow];
+      for (int32 w = 0; w < mWordsPerRow; w++)
+      {
+         uint64 bits = mask_row[w];
+         while (bits)
+         {
+            OutMatched.Add((row * mColumnCount) + (w * 64) + LowestBitIndex(bits));
+            bits &= bits - 1;       // clear the lowest set bit
+         }
+      }
+   }
+
+   return true;
+}
+
+
+
+void FMatchBitboard::ShiftDown(const uint64* Row, int32 Amount, uint64* Out) const
+{
+   const int32 word_shift = Amount / 64;
+   const int32 bit_shift = Amount % 64;
+
+   for (int32 w = 0; w < mWordsPerRow; w++)
+   {
+      const int32 src = w + word_shift;
+      uint64 value = 0;
+      if (src < mWordsPerRow)
+      {
+         value = Row[src] >> bit_shift;
+         if (bit_shift > 0 && src + 1 < mWordsPerRow)
+            value |= Row[src + 1] << (64 - bit_shift);
+      }
+      Out[w] = value;
+   }
+}
+
+void FMatchBitboard::ShiftUp(const uint64* Row, int32 Amount, uint64* Out) const
+{
+   const int32 word_shift = Amount / 64;
+   const int32 bit_shift = Amount % 64;
+
+   for (int32 w = 0; w < mWordsPerRow; w++)
+   {
+      const int32 src = w - word_shift;
+      uint64 value = 0;
+      if (src >= 0)
+      {
+         value = Row[src] << bit_shift;
+         if (bit_shift > 0 && src > 0)
+            value |= Row[src - 1] >> (64 - bit_shift);
+      }
+      Out[w] = value;
+   }
+}
+
+bool FMatchBitboard::FindTypeMatches(int32 TypeID, int32 RunSize, EMatchDirection Directions)
+{
+   // Scratch rows: "acc" holds the cells where a run begins, "tmp" receives shifted rows
+   uint64* acc = mScratch.GetData();
+   uint64* tmp = acc + mWordsPerRow;
+   uint64* const out_mask = mMask.GetData();
+
+   const int32 row_bytes = mWordsPerRow * sizeof(uint64);
+   bool found = false;
+
+   for (int32 row = 0; row < mRowCount; row++)
+   {
+      const uint64* base = GetRow(TypeID, row);
+
+      // Horizontal runs - a bit remains set in acc if the RunSize cells to its right (itself included) are occupied
+      if (EnumHasAnyFlags(Directions, EMatchDirection::Horizontal) && RunSize <= mColumnCount)
+      {
+         FMemory::Memcpy(acc, base, row_bytes);
+         bool any = true;
+         for (int32 i = 1; i < RunSize && any; i++)
+         {
+            ShiftDown(base, i, tmp);
+            any = AndInto(acc, tmp, mWordsPerRow);
+         }
+
+         if (any)
+         {
+            found = true;
+            // Expand each run start into the RunSize cells of the run
+            for (int32 i = 0; i < RunSize; i++)
+            {
+               ShiftUp(acc, i, tmp);
+               OrInto(&out_mask[row * mWordsPerRow], tmp, mWordsPerRow);
+            }
+         }
+      }
+
+      // Vertical and diagonal runs starting at this row need RunSize rows from here upwards
+      if (row + RunSize > mRowCount)
+         continue;
+
+      // Vertical runs - no shifting necessary, just AND the rows above
+      if (EnumHasAnyFlags(Directions, EMatchDirection::Vertical))
+      {
+         FMemory::Memcpy(acc, base, row_bytes);
+         bool any = true;
+         for (int32 i = 1; i < RunSize && any; i++)
+         {
+            any = AndInto(acc, GetRow(TypeID, row + i), mWordsPerRow);
+         }
+
+         if (any)
+         {
+            found = true;
+            for (int32 i = 0; i < RunSize; i++)
+            {
+               OrInto(&out_mask[(row + i) * mWordsPerRow], acc, mWordsPerRow);
+            }
+         }
+      }
+
+      // Up-right diagonal (the "down-left/up-right" pair), cells (c + i, row + i)
+      if (EnumHasAnyFlags(Directions, EMatchDirection::DiagonalUpRight))
+      {
+         FMemory::Memcpy(acc, base, row_bytes);
+         bool any = true;
+         for (int32 i = 1; i < RunSize && any; i++)
+         {
+            ShiftDown(GetRow(TypeID, row + i), i, tmp);
+            any = AndInto(acc, tmp, mWordsPerRow);
+         }
+
+         if (any)
+         {
+            found = true;
+            for (int32 i = 0; i < RunSize; i++)
+            {
+               ShiftUp(acc, i, tmp);
+               OrInto(&out_mask[(row + i) * mWordsPerRow], tmp, mWordsPerRow);
+            }
+         }
+      }
+
+      // Up-left diagonal (the "up-left/down-right" pair), cells (c - i, row + i)
+      if (EnumHasAnyFlags(Directions, EMatchDirection::DiagonalUpLeft))
+      {
+         FMemory::Memcpy(acc, base, row_bytes);
+         bool any = true;
+         for (int32 i = 1; i < RunSize && any; i++)
+         {
+            ShiftUp(GetRow(TypeID, row + i), i, tmp);
+            any = AndInto(acc, tmp, mWordsPerRow);
+         }
+
+         if (any)
+         {
+            found = true;
+            for (int32 i = 0; i < RunSize; i++)
+            {
+               ShiftDown(acc, i, tmp);
+               OrInto(&out_mask[(row + i) * mWordsPerRow], tmp, mWordsPerRow);
+            }
+         }
+      }
+   }
+
+   return found;
+}
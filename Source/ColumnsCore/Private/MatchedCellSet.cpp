@@ -0,0 +1,73 @@
+/**
+ * This source code is provided as reference/companion material for the uColumnsTutorial
+ * that can be freely found at http://www.kehomsforge.com and should not be commercialized
+ * in any form. It should remain free!
+ *
+ * By Yuri Sarudiansky
+ */
+
+#include "MatchedCellSet.h"
+
+
+void FMatchedCellSet::Init(int32 CellCount)
+{
+   mBitmap.Empty((CellCount + 63) / 64);
+   mBitmap.AddZeroed((CellCount + 63) / 64);
+
+   // Reserve enough room so insertion never has to grow the list
+   mCells.Empty(CellCount);
+   mIsSorted = true;
+}
+
+bool FMatchedCellSet::Add(int32 CellIndex)
+{
+   uint64& word = mBitmap[CellIndex / 64];
+   const uint64 bit = uint64(1) << (CellIndex % 64);
+
+   if (word & bit)
+      return false;
+
+   word |= bit;
+
+   // Appending something smaller than the last entry breaks the ascending order
+   if (mCells.Num() > 0 && mCells.Last() > CellIndex)
+      mIsSorted = false;
+
+   mCells.Add(CellIndex);
+   return true;
+}
+
+void FMatchedCellSet::Reset()
+{
+   for (int32 cell_index : mCells)
+   {
+      mBitmap[cell_index / 64] = 0;
+   }
+
+   // Reset() keeps the allocated memory, so the reservation done in Init() remains
+   mCells.Reset();
+   mIsSorted = true;
+}
+
+void FMatchedCellSet::Sort()
+{
+   if (mIsSorted)
+      return;
+
+   const int32 count = mCells.Num();
+   mCells.Reset();
+
+   for (int32 w = 0; w < mBitmap.Num() && mCells.Num() < count; w++)
+   {
+      uint64 bits = mBitmap[w];
+      while (bits)
+      {
+         const uint32 low = (uint32)bits;
+         const int32 bit = low ? FMath::CountTrailingZeros(low) : 32 + FMath::CountTrailingZeros((uint32)(bits >> 32));
+         mCells.Add(w * 64 + bit);
+         bits &= bits - 1;    // clear the lowest set bit
+      }
+   }
+
+   mIsSorted = true;
+}
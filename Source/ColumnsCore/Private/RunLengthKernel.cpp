@@ -0,0 +1,477 @@
+/**
+ * This source code is provided as reference/companion material for the uColumnsTutorial
+ * that can be freely found at http://www.kehomsforge.com and should not be commercialized
+ * in any form. It should remain free!
+ *
+ * By Yuri Sarudiansky
+ */
+
+#include "RunLengthKernel.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+   #define COLUMNS_RUN_KERNEL_X86 1
+#else
+   #define COLUMNS_RUN_KERNEL_X86 0
+#endif
+
+#if COLUMNS_RUN_KERNEL_X86
+   #include <immintrin.h>
+   #if defined(_MSC_VER) && !defined(__clang__)
+      #include <intrin.h>
+      // MSVC allows AVX2 intrinsics anywhere
+      #define COLUMNS_TARGET_AVX2
+   #else
+      // GCC and Clang need the instruction set enabled per function
+      #define COLUMNS_TARGET_AVX2 __attribute__((target("avx2")))
+   #endif
+#endif
+
+
+// Byte operations of a kernel. Flag bytes are either 0 or 0xFF
+struct FRunKernelOps
+{
+   // Out[i] = (A[i] == B[i] && A[i] >= 0) ? 0xFF : 0
+   void (*CompareEqual)(const int8* A, const int8* B, uint8* Out, int32 Count);
+   // Acc[i] &= Src[i], returning true if any flag remains set
+   bool (*AndInto)(uint8* Acc, const uint8* Src, int32 Count);
+   // Acc[i] |= Src[i]
+   void (*OrInto)(uint8* Acc, const uint8* Src, int32 Count);
+   // Add BaseIndex + i for every set flag into OutMatched, in ascending order
+   void (*Emit)(const uint8* Flags, int32 Count, int32 BaseIndex, FMatchedCellSet& OutMatched);
+};
+
+
+namespace
+{
+   /// Scalar kernel. Works on 8 bytes at a time whenever possible
+
+   void ScalarCompareEqual(const int8* A, const int8* B, uint8* Out, int32 Count)
+   {
+      for (int32 i = 0; i < Count; i++)
+      {
+         Out[i] = (A[i] == B[i] && A[i] >= 0) ? 0xFF : 0;
+      }
+   }
+
+   bool ScalarAndInto(uint8* Acc, const uint8* Src, int32 Count)
+   {
+      uint64 any = 0;
+      int32 i = 0;
+      for (; i + 8 <= Count; i += 8)
+      {
+         uint64 acc, src;
+         FMemory::Memcpy(&acc, Acc + i, 8);
+         FMemory::Memcpy(&src, Src + i, 8);
+         acc &= src;
+         FMemory::Memcpy(Acc + i, &acc, 8);
+         any |= acc;
+      }
+      for (; i < Count; i++)
+      {
+         Acc[i] &= Src[i];
+         any |= Acc[i];
+      }
+      return any != 0;
+   }
+
+   void ScalarOrInto(uint8* Acc, const uint8* Src, int32 Count)
+   {
+      int32 i = 0;
+      for (; i + 8 <= Count; i += 8)
+      {
+         uint64 acc, src;
+         FMemory::Memcpy(&acc, Acc + i, 8);
+         FMemory::Memcpy(&src, Src + i, 8);
+         acc |= src;
+         FMemory::Memcpy(Acc + i, &acc, 8);
+      }
+      for (; i < Count; i++)
+      {
+         Acc[i] |= Src[i];
+      }
+   }
+
+   void ScalarEmit(const uint8* Flags, int32 Count, int32 BaseIndex, FMatchedCellSet& OutMatched)
+   {
+      int32 i = 0;
+      for (; i + 8 <= Count; i += 8)
+      {
+         uint64 chunk;
+         FMemory::Memcpy(&chunk, Flags + i, 8);
+         if (chunk == 0)
+            continue;
+
+         for (int32 b = 0; b < 8; b++)
+         {
+            if (Flags[i + b])
+               OutMatched.Add(BaseIndex + i + b);
+         }
+      }
+      for (; i < Count; i++)
+      {
+         if (Flags[i])
+            OutMatched.Add(BaseIndex + i);
+      }
+   }
+
+   const FRunKernelOps ScalarOps = { &ScalarCompareEqual, &ScalarAndInto, &ScalarOrInto, &ScalarEmit };
+
+
+#if COLUMNS_RUN_KERNEL_X86
+   /// SSE2 kernel, 16 cells per operation. The tails are handled by the scalar functions
+
+   void SSE2CompareEqual(const int8* A, const int8* B, uint8* Out, int32 Count)
+   {
+      const __m128i neg_one = _mm_set1_epi8(-1);
+      int32 i = 0;
+      for (; i + 16 <= Count; i += 16)
+      {
+         const __m128i a = _mm_loadu_si128((const __m128i*)(A + i));
+         const __m128i b = _mm_loadu_si128((const __m128i*)(B + i));
+         // Equal and not empty (empty cells hold negative values)
+         const __m128i eq = _mm_and_si128(_mm_cmpeq_epi8(a, b), _mm_cmpgt_epi8(a, neg_one));
+         _mm_storeu_si128((__m128i*)(Out + i), eq);
+      }
+      ScalarCompareEqual(A + i, B + i, Out + i, Count - i);
+   }
+
+   bool SSE2AndInto(uint8* Acc, const uint8* Src, int32 Count)
+   {
+      __m128i any = _mm_setzero_si128();
+      int32 i = 0;
+      for (; i + 16 <= Count; i += 16)
+      {
+         const __m128i acc = _mm_and_si128(_mm_loadu_si128((const __m128i*)(Acc + i)), _mm_loadu_si128((const __m128i*)(Src + i)));
+         _mm_storeu_si128((__m128i*)(Acc + i), acc);
+         any = _mm_or_si128(any, acc);
+      }
+      const bool tail_any = ScalarAndInto(Acc + i, Src + i, Count - i);
+      return tail_any || _mm_movemask_epi8(_mm_cmpeq_epi8(any, _mm_setzero_si128())) != 0xFFFF;
+   }
+
+   void SSE2OrInto(uint8* Acc, const uint8* Src, int32 Count)
+   {
+      int32 i = 0;
+      for (; i + 16 <= Count; i += 16)
+      {
+         const __m128i acc = _mm_or_si128(_mm_loadu_si128((const __m128i*)(Acc + i)), _mm_loadu_si128((const __m128i*)(Src + i)));
+         _mm_storeu_si128((__m128i*)(Acc + i), acc);
+      }
+      ScalarOrInto(Acc + i, Src + i, Count - i);
+   }
+
+   void SSE2Emit(const uint8* Flags, int32 Count, int32 BaseIndex, FMatchedCellSet& OutMatched)
+   {
+      int32 i = 0;
+      for (; i + 16 <= Count; i += 16)
+      {
+         uint32 bits = (uint32)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(Flags + i)));
+         while (bits)
+         {
+            OutMatched.Add(BaseIndex + i + FMath::CountTrailingZeros(bits));
+            bits &= bits - 1;
+         }
+      }
+      ScalarEmit(Flags + i, Count - i, BaseIndex + i, OutMatched);
+   }
+
+   const FRunKernelOps SSE2Ops = { &SSE2CompareEqual, &SSE2AndInto, &SSE2OrInto, &SSE2Emit };
+
+
+   /// AVX2 kernel, 32 cells per operation. The tails are handled by the scalar functions, mixing in the SSE2 ones
+   /// would incur AVX/SSE transition penalties
+
+   COLUMNS_TARGET_AVX2 void AVX2CompareEqual(const int8* A, const int8* B, uint8* Out, int32 Count)
+   {
+      const __m256i neg_one = _mm256_set1_epi8(-1);
+      int32 i = 0;
+      for (; i + 32 <= Count; i += 32)
+      {
+         const __m256i a = _mm256_loadu_si256((const __m256i*)(A + i));
+         const __m256i b = _mm256_loadu_si256((const __m256i*)(B + i));
+         const __m256i eq = _mm256_and_si256(_mm256_cmpeq_epi8(a, b), _mm256_cmpgt_epi8(a, neg_one));
+         _mm256_storeu_si256((__m256i*)(Out + i), eq);
+      }
+      ScalarCompareEqual(A + i, B + i, Out + i, Count - i);
+   }
+
+   COLUMNS_TARGET_AVX2 bool AVX2AndInto(uint8* Acc, const uint8* Src, int32 Count)
+   {
+      __m256i any = _mm256_setzero_si256();
+      int32 i = 0;
+      for (; i + 32 <= Count; i += 32)
+      {
+         const __m256i acc = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(Acc + i)), _mm256_loadu_si256((const __m256i*)(Src + i)));
+         _mm256_storeu_si256((__m256i*)(Acc + i), acc);
+         any = _mm256_or_si256(any, acc);
+      }
+      const bool tail_any = ScalarAndInto(Acc + i, Src + i, Count - i);
+      return tail_any || !_mm256_testz_si256(any, any);
+   }
+
+   COLUMNS_TARGET_AVX2 void AVX2OrInto(uint8* Acc, const uint8* Src, int32 Count)
+   {
+      int32 i = 0;
+      for (; i + 32 <= Count; i += 32)
+      {
+         const __m256i acc = _mm256_or_si256(_mm256_loadu_si256((const __m256i*)(Acc + i)), _mm256_loadu_si256((const __m256i*)(Src + i)));
+         _mm256_storeu_si256((__m256i*)(Acc + i), acc);
+      }
+      ScalarOrInto(Acc + i, Src + i, Count - i);
+   }
+
+   COLUMNS_TARGET_AVX2 void AVX2Emit(const uint8* Flags, int32 Count, int32 BaseIndex, FMatchedCellSet& OutMatched)
+   {
+      int32 i = 0;
+      for (; i + 32 <= Count; i += 32)
+      {
+         uint32 bits = (uint32)_mm256_movemask_epi8(_mm256_loadu_si256((const __m256i*)(Flags + i)));
+         while (bits)
+         {
+            OutMatched.Add(BaseIndex + i + FMath::CountTrailingZeros(bits));
+            bits &= bits - 1;
+         }
+      }
+      ScalarEmit(Flags + i, Count - i, BaseIndex + i, OutMatched);
+   }
+
+   const FRunKernelOps AVX2Ops = { &AVX2CompareEqual, &AVX2AndInto, &AVX2OrInto, &AVX2Emit };
+
+
+   bool CPUHasAVX2()
+   {
+   #if defined(_MSC_VER) && !defined(__clang__)
+      int info[4];
+      __cpuid(info, 0);
+      if (info[0] < 7)
+         return false;
+
+      // The OS must save the YMM registers on context switches
+      __cpuid(info, 1);
+      const bool osxsave = (info[2] & (1 << 27)) != 0;
+      const bool avx = (info[2] & (1 << 28)) != 0;
+      if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+         return false;
+
+      __cpuidex(info, 7, 0);
+      return (info[1] & (1 << 5)) != 0;
+   #else
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2") != 0;
+   #endif
+   }
+#endif     // COLUMNS_RUN_KERNEL_X86
+}
+
+
+
+FRunLengthKernel::FRunLengthKernel()
+   : mPaddedCount(0)
+{
+   SetKernel(GetBestSupported());
+   SetRules(FMatchRules());
+}
+
+FRunLengthKernel::FRunLengthKernel(const FRunLengthKernel& Other)
+   : mPaddedCount(0)
+{
+   SetKernel(Other.mKernel);
+   SetRules(Other.mRules);
+}
+
+FRunLengthKernel& FRunLengthKernel::operator=(const FRunLengthKernel& Other)
+{
+   SetKernel(Other.mKernel);
+   SetRules(Other.mRules);
+   return *this;
+}
+
+ERunKernel FRunLengthKernel::GetBestSupported()
+{
+#if COLUMNS_RUN_KERNEL_X86
+   // Detecting is not free, so do it only once
+   static const bool has_avx2 = CPUHasAVX2();
+   // Every x86 CPU able to run the engine supports SSE2
+   return has_avx2 ? ERunKernel::AVX2 : ERunKernel::SSE2;
+#else
+   return ERunKernel::Scalar;
+#endif
+}
+
+bool FRunLengthKernel::IsSupported(ERunKernel Kernel)
+{
+   return Kernel <= GetBestSupported();
+}
+
+const TCHAR* FRunLengthKernel::GetName(ERunKernel Kernel)
+{
+   switch (Kernel)
+   {
+      case ERunKernel::SSE2:
+         return TEXT("SSE2");
+      case ERunKernel::AVX2:
+         return TEXT("AVX2");
+      default:
+         return TEXT("Scalar");
+   }
+}
+
+void FRunLengthKernel::SetKernel(ERunKernel Kernel)
+{
+   mKernel = IsSupported(Kernel) ? Kernel : GetBestSupported();
+
+   switch (mKernel)
+   {
+#if COLUMNS_RUN_KERNEL_X86
+      case ERunKernel::SSE2:
+         mOps = &SSE2Ops;
+         break;
+      case ERunKernel::AVX2:
+         mOps = &AVX2Ops;
+         break;
+#endif
+      default:
+         mOps = &ScalarOps;
+         break;
+   }
+}
+
+void FRunLengthKernel::SetRules(const FMatchRules& Rules)
+{
+   mRules = Rules;
+
+   // The generic code handles anything not covered by the specializations
+   mFindMatches = &FRunLengthKernel::FindMatchesImpl<0, EMatchDirection::None>;
+
+   #define COLUMNS_SELECT_RULES(Size, Dirs) \
+      if (mRules.RunSize == Size && mRules.Directions == EMatchDirection::Dirs) \
+         mFindMatches = &FRunLengthKernel::FindMatchesImpl<Size, EMatchDirection::Dirs>;
+
+   COLUMNS_SELECT_RULES(3, All)
+   COLUMNS_SELECT_RULES(3, Orthogonal)
+   COLUMNS_SELECT_RULES(4, All)
+   COLUMNS_SELECT_RULES(4, Orthogonal)
+   COLUMNS_SELECT_RULES(5, All)
+   COLUMNS_SELECT_RULES(5, Orthogonal)
+
+   #undef COLUMNS_SELECT_RULES
+}
+
+bool FRunLengthKernel::IsSpecialized() const
+{
+   return mFindMatches != &FRunLengthKernel::FindMatchesImpl<0, EMatchDirection::None>;
+}
+
+template <int32 FixedRunSize, EMatchDirection FixedDirections>
+bool FRunLengthKernel::FindMatchesImpl(const int8* TypePlane, int32 ColumnCount, int32 RowCount, FMatchedCellSet& OutMatched)
+{
+   // With fixed rules both values are compile time constants and the tests below that don't apply are removed.
+   // A run must hold at least one block
+   const int32 run_size = FixedRunSize > 0 ? FixedRunSize : FMath::Max(mRules.RunSize, 1);
+   const EMatchDirection directions = FixedRunSize > 0 ? FixedDirections : mRules.Directions;
+
+   const int32 cell_count = ColumnCount * RowCount;
+   if (cell_count <= 0)
+      return false;
+
+   // Shifted reads and writes go at most RunSize rows (plus RunSize columns) past the end of the planes
+   mPaddedCount = cell_count + (run_size + 1) * (ColumnCount + 1);
+   if (mMask.Num() < mPaddedCount)
+   {
+      mEqual.SetNumZeroed(mPaddedCount);
+      mStart.SetNumZeroed(mPaddedCount);
+      mMask.SetNumZeroed(mPaddedCount);
+   }
+   FMemory::Memzero(mMask.GetData(), cell_count);
+
+   bool found = false;
+   if (run_size == 1)
+   {
+      // Every block is a run by itself, as long as any direction is enabled
+      if (directions != EMatchDirection::None)
+      {
+         for (int32 i = 0; i < cell_count; i++)
+         {
+            mMask[i] = TypePlane[i] >= 0 ? 0xFF : 0;
+            found |= mMask[i] != 0;
+         }
+      }
+   }
+   else
+   {
+      const bool fits_row = run_size <= ColumnCount;
+      const bool fits_column = run_size <= RowCount;
+
+      // Horizontal, the last column has no neighbor to the right
+      if (fits_row && EnumHasAnyFlags(directions, EMatchDirection::Horizontal))
+         found |= FindDirection<FixedRunSize>(TypePlane, ColumnCount, cell_count, 1, ColumnCount - 1, run_size);
+
+      // Vertical
+      if (fits_column && EnumHasAnyFlags(directions, EMatchDirection::Vertical))
+         found |= FindDirection<FixedRunSize>(TypePlane, ColumnCount, cell_count, ColumnCount, -1, run_size);
+
+      // Up-right diagonal, the last column has no neighbor to the up-right
+      if (fits_row && fits_column && EnumHasAnyFlags(directions, EMatchDirection::DiagonalUpRight))
+         found |= FindDirection<FixedRunSize>(TypePlane, ColumnCount, cell_count, ColumnCount + 1, ColumnCount - 1, run_size);
+
+      // Up-left diagonal, the first column has no neighbor to the up-left
+      if (fits_row && fits_column && EnumHasAnyFlags(directions, EMatchDirection::DiagonalUpLeft))
+         found |= FindDirection<FixedRunSize>(TypePlane, ColumnCount, cell_count, ColumnCount - 1, 0, run_size);
+   }
+
+   if (found)
+   {
+      mOps->Emit(mMask.GetData(), cell_count, 0, OutMatched);
+   }
+   return found;
+}
+
+template <int32 FixedRunSize>
+bool FRunLengthKernel::FindDirection(const int8* TypePlane, int32 ColumnCount, int32 CellCount, int32 Step, int32 ExcludedColumn, int32 DynamicRunSize)
+{
+   // Constant bounds for the loops below whenever the rules are fixed
+   const int32 run_size = FixedRunSize > 0 ? FixedRunSize : DynamicRunSize;
+
+   uint8* equal = mEqual.GetData();
+   uint8* start = mStart.GetData();
+
+   // Flag the cells holding the same block as their neighbor in this direction. Cells in the top rows have no
+   // neighbor, their flags are cleared along with the padding
+   const int32 compare_count = CellCount - Step;
+   mOps->CompareEqual(TypePlane, TypePlane + Step, equal, compare_count);
+   FMemory::Memzero(equal + compare_count, mPaddedCount - compare_count);
+
+   // Cells in the excluded column would be compared with a cell in the next row, which is not their neighbor
+   if (ExcludedColumn >= 0)
+   {
+      for (int32 index = ExcludedColumn; index < CellCount; index += ColumnCount)
+      {
+         equal[index] = 0;
+      }
+   }
+
+   // A run begins at the cells where RunSize - 1 consecutive flags are set
+   FMemory::Memcpy(start, equal, CellCount);
+   bool any = true;
+   for (int32 i = 1; i < run_size - 1 && any; i++)
+   {
+      any = mOps->AndInto(start, equal + i * Step, CellCount);
+   }
+
+   if (run_size == 2)
+   {
+      // No AND pass was made, check if there is anything flagged
+      any = mOps->AndInto(start, start, CellCount);
+   }
+
+   if (!any)
+      return false;
+
+   // Expand each run start into the RunSize cells of the run
+   uint8* mask = mMask.GetData();
+   for (int32 i = 0; i < run_size; i++)
+   {
+      mOps->OrInto(mask + i * Step, start, CellCount);
+   }
+   return true;
+}
@@ -0,0 +1,130 @@
+/**
+ * This source code is provided as reference/companion material for the uColumnsTutorial
+ * that can be freely found at http://www.kehomsforge.com and should not be commercialized
+ * in any form. It should remain free!
+ *
+ * By Yuri Sarudiansky
+ */
+
+#include "TweenScheduler.h"
+
+
+void FTweenScheduler::Add(int32 Target, const FVector& Start, const FVector& End, float Duration, ETweenEasing Easing, float Delay)
+{
+   mTarget.Add(Target);
+   mStart.Add(Start);
+   mEnd.Add(End);
+   mStartTime.Add(mTime + Delay);
+   mDuration.Add(Duration);
+   mEasing.Add(Easing);
+   mValue.Add(Start);
+}
+
+void FTweenScheduler::Update(float DeltaSeconds)
+{
+   RemoveCompleted();
+
+   // Restart the clock whenever idle so it never grows large enough to lose precision
+   if (mTarget.Num() == 0)
+   {
+      mTime = 0.0f;
+      return;
+   }
+
+   mTime += DeltaSeconds;
+
+   const int32 count = mTarget.Num();
+   mUpdatedCount = count;
+   for (int32 i = 0; i < count; i++)
+   {
+      const float alpha = GetAlpha(i);
+
+      if (alpha >= 1.0f)
+      {
+         mValue[i] = mEnd[i];
+         mCompleted.Add(mTarget[i]);
+      }
+      else
+      {
+         mValue[i] = FMath::Lerp(mStart[i], mEnd[i], Ease(mEasing[i], alpha));
+      }
+   }
+}
+
+void FTweenScheduler::Reset()
+{
+   mTarget.Reset();
+   mStart.Reset();
+   mEnd.Reset();
+   mStartTime.Reset();
+   mDuration.Reset();
+   mEasing.Reset();
+   mValue.Reset();
+   mCompleted.Reset();
+   mUpdatedCount = 0;
+   mTime = 0.0f;
+}
+
+void FTweenScheduler::Reserve(int32 Count)
+{
+   mTarget.Reserve(Count);
+   mStart.Reserve(Count);
+   mEnd.Reserve(Count);
+   mStartTime.Reserve(Count);
+   mDuration.Reserve(Count);
+   mEasing.Reserve(Count);
+   mValue.Reserve(Count);
+   mCompleted.Reserve(Count);
+}
+
+float FTweenScheduler::Ease(ETweenEasing Easing, float Alpha)
+{
+   switch (Easing)
+   {
+      case ETweenEasing::EaseIn:
+         return Alpha * Alpha;
+      case ETweenEasing::EaseOut:
+         return Alpha * (2.0f - Alpha);
+      case ETweenEasing::EaseInOut:
+         return Alpha < 0.5f ? 2.0f * Alpha * Alpha : -1.0f + (4.0f - 2.0f * Alpha) * Alpha;
+      default:
+         return Alpha;
+   }
+}
+
+void FTweenScheduler::RemoveCompleted()
+{
+   if (mCompleted.Num() == 0)
+      return;
+
+   // The clock has not moved since the last update, so the same alpha test finds the completed tweens
+   const int32 count = mTarget.Num();
+   int32 write = 0;
+   for (int32 read = 0; read < count; read++)
+   {
+      if (read < mUpdatedCount && GetAlpha(read) >= 1.0f)
+         continue;
+
+      if (write != read)
+      {
+         mTarget[write] = mTarget[read];
+         mStart[write] = mStart[read];
+         mEnd[write] = mEnd[read];
+         mStartTime[write] = mStartTime[read];
+         mDuration[write] = mDuration[read];
+         mEasing[write] = mEasing[read];
+         mValue[write] = mValue[read];
+      }
+      write++;
+   }
+
+   mTarget.SetNum(write, false);
+   mStart.SetNum(write, false);
+   mEnd.SetNum(write, false);
+   mStartTime.SetNum(write, false);
+   mDuration.SetNum(write, false);
+   mEasing.SetNum(write, false);
+   mValue.SetNum(write, false);
+
+   mCompleted.Reset();
+}
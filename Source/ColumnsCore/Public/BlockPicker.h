@@ -0,0 +1,46 @@
+/**
+ * This source code is provided as reference/companion material for the uColumnsTutorial
+ * that can be freely found at http://www.kehomsforge.com and should not be commercialized
+ * in any form. It should remain free!
+ *
+ * By Yuri Sarudiansky
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Weighted random selection of block types. The weights are usually taken from the theme's block collection.
+// SetWeights() builds an alias table (Vose's method) so each pick costs the same no matter how many types there are:
+// the roll selects a column, then either the column's own type or its alias
+class COLUMNSCORE_API FBlockPicker
+{
+public:
+   FBlockPicker()
+      : mWeightSum(0.0f)
+   {}
+
+   // Replace the weights, one per block type
+   void SetWeights(const TArray<float>& Weights);
+
+   int32 Num() const { return mWeight.Num(); }
+   float GetWeightSum() const { return mWeightSum; }
+
+   // Select the block type corresponding to the Roll, which must be in the [0, GetWeightSum()] range. Returns -1
+   // if there are no weights
+   int32 Pick(float Roll) const { return PickFraction(mWeightSum > 0.0f ? Roll / mWeightSum : 0.0f); }
+
+   // Select a block type using the specified random stream
+   int32 Pick(const FRandomStream& Stream) const { return PickFraction(Stream.GetFraction()); }
+
+   // Select the block type corresponding to the Fraction, in the [0, 1] range. Returns -1 if there are no weights
+   int32 PickFraction(float Fraction) const;
+
+private:
+   TArray<float> mWeight;
+   float mWeightSum;
+
+   // Chance, in the [0, 1] range, of each column of the table selecting its own type rather than the alias
+   TArray<float> mProbability;
+   TArray<int32> mAlias;
+};
@@ -0,0 +1,136 @@
+/**
+ * This source code is provided as reference/companion material for the uColumnsTutorial
+ * that can be freely found at http://www.kehomsforge.com and should not be commercialized
+ * in any form. It should remain free!
+ *
+ * By Yuri Sarudiansky
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/ArrayView.h"
+#include "ColumnsBoard.h"
+#include "MatchedCellSet.h"
+
+// Gameplay values the resolver needs in order to simulate a cascade. What forms a match is defined by the
+// board's match rules
+struct FCascadeRules
+{
+   FCascadeRules()
+      : ScorePerBlock(5)
+      , InitialMultiplier(1.0f)
+      , MultiplierDelta(1.0f)
+   {}
+
+   // Base score given by each matched block
+   int32 ScorePerBlock;
+   // Bonus multiplier applied to the first wave
+   float InitialMultiplier;
+   // How much the bonus multiplier increases after each wave
+   float MultiplierDelta;
+};
+
+// A block that must fall after the matched blocks of a wave are removed
+struct FCascadeMove
+{
+   FCascadeMove(int32 From = -1, int32 To = -1, int32 Cells = 0)
+      : FromCell(From)
+      , ToCell(To)
+      , Distance(Cells)
+   {}
+
+   int32 FromCell;
+   int32 ToCell;
+   // Amount of rows the block falls
+   int32 Distance;
+};
+
+// New floor level of a column that has been changed by a wave
+struct FCascadeFloor
+{
+   FCascadeFloor(int32 InColumn = -1, int32 InFloor = 0)
+      : Column(InColumn)
+      , Floor(InFloor)
+   {}
+
+   int32 Column;
+   int32 Floor;
+};
+
+// Everything that happens in a single match -> remove -> collapse step of a cascade
+struct FCascadeWave
+{
+   FCascadeWave()
+      : Score(0)
+      , Multiplier(1.0f)
+   {}
+
+   // Cells forming matching runs, in ascending order
+   TArray<int32> MatchedCells;
+   // Blocks falling into the gaps, ordered bottom-up within each column
+   TArray<FCascadeMove> Moves;
+   // Floor levels of the columns that lost blocks
+   TArray<FCascadeFloor> Floors;
+   // Score given by this wave
+   int32 Score;
+   // Bonus multiplier used to calculate the score
+   float Multiplier;
+};
+
+
+// Computes, from the moment blocks are placed, the entire chain of matches and collapses they trigger. The result
+// is a timeline of waves that can be played back by the game mode while the final board and score are known
+// right away.
+class COLUMNSCORE_API FCascadeResolver
+{
+public:
+   FCascadeResolver()
+      : mMatchedCellCount(0)
+      , mWaveCount(0)
+      , mTotalScore(0)
+      , mFinalMultiplier(1.0f)
+   {}
+
+   // Simulate the cascade triggered by the blocks placed at LandedCells. The board is not modified, the
+   // simulation runs on an internal copy
+   void Resolve(const FColumnsBoard& Board, const TArray<int32>& LandedCells, const FCascadeRules& Rules);
+
+   // Same as Resolve() but the cascade is applied directly to the specified board, which then holds the final
+   // state. GetFinalBoard() is not updated in this case
+   void ResolveInPlace(FColumnsBoard& Board, const TArray<int32>& LandedCells, const FCascadeRules& Rules);
+
+   // The waves of the last resolved cascade. Wave objects are reused between calls to avoid allocations
+   TArrayView<const FCascadeWave> GetWaves() const { return TArrayView<const FCascadeWave>(mWaves.GetData(), mWaveCount); }
+
+   // Sum of the scores of all waves
+   int32 GetTotalScore() const { return mTotalScore; }
+
+   // Bonus multiplier after the last wave
+   float GetFinalMultiplier() const { return mFinalMultiplier; }
+
+   // The board once the cascade resolved by Resolve() is over
+   const FColumnsBoard& GetFinalBoard() const { return mBoard; }
+
+private:
+   // Remove the matched blocks from the board and let the blocks above them fall, filling the wave's moves and floors
+   void Collapse(FColumnsBoard& Board, FCascadeWave& Wave);
+
+   // Copy of the board used by Resolve()
+   FColumnsBoard mBoard;
+
+   // Scratch data reused between waves
+   FMatchedCellSet mMatched;
+   int32 mMatchedCellCount;
+   // Lowest row from which blocks have been removed in each column, -1 if nothing was removed from the column
+   TArray<int32> mColumnLowestRemoved;
+   // Columns that lost blocks in the current wave
+   TArray<int32> mDirtyColumn;
+   // Cells that received blocks since the last match check
+   TArray<int32> mChanged;
+
+   TArray<FCascadeWave> mWaves;
+   int32 mWaveCount;
+   int32 mTotalScore;
+   float mFinalMultiplier;
+};
@@ -0,0 +1,165 @@
+/**
+ * This source code is provided as reference/companion material for the uColumnsTutorial
+ * that can be freely found at http://www.kehomsforge.com and should not be commercialized
+ * in any form. It should remain free!
+ *
+ * By Yuri Sarudiansky
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MatchedCellSet.h"
+#include "RunLengthKernel.h"
+#include "MatchBitboard.h"
+
+// The playfield as plain data, holding everything the gameplay rules need and nothing related to the visuals.
+// Cells are indexed bottom-up, row major and column/row are derived from the index. The block type of each
+// cell is kept in a byte plane (-1 meaning empty), which is scanned by a vector kernel to find matching runs.
+// Without vector extensions wide boards are scanned through per type bit planes instead, kept alongside the byte
+// plane only while that path is in use. The floor of each column (the row right above its highest block) is also
+// tracked.
+class COLUMNSCORE_API FColumnsBoard
+{
+public:
+   FColumnsBoard()
+      : mColumnCount(0)
+      , mRowCount(0)
+      , mLocalMatchBase(DefaultLocalMatchBase)
+      , mLocalMatchDensity(DefaultLocalMatchDensity)
+      , mBitboardMinColumns(DefaultBitboardMinColumns)
+      , mUseBitboard(false)
+   {}
+
+   // Crossover between probing changed cells individually and sweeping the entire board, which is at
+   // Base + Density * CellCount changed cells. Probing costs 30-50ns per cell while the AVX2 sweep has a fixed
+   // cost of roughly 100ns and then grows with the board size, hence the two values. Measured crossovers were
+   // 5 cells on 9x16, 18 on 32x64, 318 on 128x256 and 1452 on 256x512
+   static constexpr int32 DefaultLocalMatchBase = 4;
+   static constexpr float DefaultLocalMatchDensity = 0.01f;
+
+   // Narrowest board scanned with the bitboard rather than the scalar kernel. The bitboard cost follows the amount
+   // of 64 bit words per row, so it only pays off once rows fill them: 32 and 48 column boards were faster with the
+   // scalar kernel at any height, 64 columns and more with the bitboard. The vector kernels are faster than the
+   // bitboard at every size, so they are always used when available
+   static constexpr int32 DefaultBitboardMinColumns = 64;
+
+   // Value held by the type plane in empty cells
+   static const int8 EmptyCell = -1;
+
+   // Setup the dimensions, leaving all cells empty
+   void Init(int32 ColumnCount, int32 RowCount);
+
+   // Empty all cells, keeping the dimensions
+   void Reset();
+
+   int32 GetColumnCount() const { return mColumnCount; }
+   int32 GetRowCount() const { return mRowCount; }
+   int32 GetCellCount() const { return mTypePlane.Num(); }
+
+   // Returns -1 if the column/row pair is outside of the board
+   int32 GetCellIndex(int32 Column, int32 Row) const
+   {
+      if (Column < 0 || Column >= mColumnCount || Row < 0 || Row >= mRowCount)
+         return -1;
+      return (mColumnCount * Row) + Column;
+   }
+
+   int32 GetColumn(int32 CellIndex) const { return CellIndex % mColumnCount; }
+   int32 GetRow(int32 CellIndex) const { return CellIndex / mColumnCount; }
+
+   bool IsValidIndex(int32 CellIndex) const { return mTypePlane.IsValidIndex(CellIndex); }
+
+   bool IsEmpty(int32 CellIndex) const { return mTypePlane[CellIndex] == EmptyCell; }
+
+   int32 GetType(int32 CellIndex) const { return mTypePlane[CellIndex]; }
+
+   // Direct access to the type plane, meant for tight loops
+   const int8* GetTypeData() const { return mTypePlane.GetData(); }
+
+
+   int32 GetFloor(int32 Column) const { return mFloor[Column]; }
+   const TArray<int32>& GetFloors() const { return mFloor; }
+
+   // Directly set the floor level of a column. Meant to be used when blocks are removed from the column
+   void SetFloor(int32 Column, int32 Floor) { mFloor[Column] = Floor; }
+
+   // Rescan every column from the top in order to find the floor levels
+   void RefreshFloors();
+
+
+   // Place a block of the specified type into the cell, replacing whatever was there. The floor of the column is
+   // raised if necessary
+   void SetCell(int32 CellIndex, int32 TypeID);
+
+   // Empty the cell. The floor level is not changed since gaps are dealt with by the cascade resolver
+   void ClearCell(int32 CellIndex);
+
+   // Place the blocks of a player piece, bottom-up, on top of the specified column. The indices of the cells
+   // receiving the blocks are appended into OutLanded. Returns false, without touching the board, if the piece
+   // does not fit in the column
+   bool PlacePiece(int32 Column, const int32* Types, int32 Count, TArray<int32>& OutLanded);
+
+
+   // Count how many blocks, starting from the cell next to the specified one and walking by the column/row steps,
+   // match the requested block type
+   int32 CountRun(int32 Column, int32 Row, int32 ColumnStep, int32 RowStep, int32 TypeID) const;
+
+   // Tell if placing a block of the specified type in the cell would form a run according to the match rules
+   bool FormsRun(int32 Column, int32 Row, int32 TypeID) const;
+
+   // Find every matching run on the board. Check FRunLengthKernel::FindMatches()
+   bool FindMatches(FMatchedCellSet& OutMatched) const;
+
+   // Find the matching runs going through the specified cells by walking from each one of them
+   bool FindMatchesAround(const TArray<int32>& Cells, FMatchedCellSet& OutMatched) const;
+
+   // Find the matching runs formed after blocks have been placed into the Changed cells. Every run existing before
+   // that is assumed to have been removed already, so both strategies give the same result: the changed cells are
+   // probed individually if they are few compared to the board size, otherwise the entire board is swept. Indices
+   // are added into OutMatched in ascending order
+   bool FindMatchesAfterChange(const TArray<int32>& Changed, FMatchedCellSet& OutMatched) const;
+
+   // Tune the crossover between the local probing and the full sweep used by FindMatchesAfterChange()
+   void SetLocalMatchCrossover(int32 Base, float Density) { mLocalMatchBase = Base; mLocalMatchDensity = Density; }
+   int32 GetLocalMatchBase() const { return mLocalMatchBase; }
+   float GetLocalMatchDensity() const { return mLocalMatchDensity; }
+
+   // Set what forms a match. This should be done once per game since the specialized matching code is selected here
+   void SetMatchRules(const FMatchRules& Rules) { mMatchKernel.SetRules(Rules); }
+   const FMatchRules& GetMatchRules() const { return mMatchKernel.GetRules(); }
+
+   // Select the instruction set used to scan for matching runs. By default the best one supported by the CPU is used
+   void SetMatchKernel(ERunKernel Kernel) { mMatchKernel.SetKernel(Kernel); RefreshMatchPath(); }
+   ERunKernel GetMatchKernel() const { return mMatchKernel.GetKernel(); }
+
+   // Tune the column count from which the bitboard replaces the scalar kernel
+   void SetBitboardMinColumns(int32 MinColumns) { mBitboardMinColumns = MinColumns; RefreshMatchPath(); }
+   int32 GetBitboardMinColumns() const { return mBitboardMinColumns; }
+
+   // Tell if FindMatches() currently scans the bitboard instead of the type plane
+   bool IsUsingBitboard() const { return mUseBitboard; }
+
+private:
+   // Enable or disable the bitboard according to the kernel and board size, rebuilding it from the type plane
+   void RefreshMatchPath();
+
+   int32 mColumnCount;
+   int32 mRowCount;
+
+   // Block type of each cell
+   TArray<int8> mTypePlane;
+   // Floor level of each column
+   TArray<int32> mFloor;
+
+   // Holds the match rules and scratch memory, the latter being why this is mutable
+   mutable FRunLengthKernel mMatchKernel;
+
+   int32 mLocalMatchBase;
+   float mLocalMatchDensity;
+
+   // Per type bit planes, only maintained while mUseBitboard is set. Mutable because it holds scratch memory
+   mutable FMatchBitboard mBitboard;
+   int32 mBitboardMinColumns;
+   bool mUseBitboard;
+};
@@ -0,0 +1,70 @@
+/**
+ * This source code is provided as reference/companion material for the uColumnsTutorial
+ * that can be freely found at http://www.kehomsforge.com and should not be commercialized
+ * in any form. It should remain free!
+ *
+ * By Yuri Sarudiansky
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MatchedCellSet.h"
+#include "MatchRules.h"
+
+// Keeps one occupancy bit plane per block type. Each grid row is stored as a sequence of 64 bit words where
+// bit N corresponds to column N. Matching runs are then found with shift-and-AND operations over whole rows
+// rather than walking cell by cell. The cost grows with the column count / 64 instead of the column count, which is
+// what makes it pay off against the scalar run length kernel on large boards.
+class COLUMNSCORE_API FMatchBitboard
+{
+public:
+   FMatchBitboard()
+      : mColumnCount(0)
+      , mRowCount(0)
+      , mWordsPerRow(0)
+   {}
+
+   // Setup the dimensions. Any previously stored data is lost
+   void Init(int32 ColumnCount, int32 RowCount);
+
+   // Remove every block from all the planes, keeping the dimensions
+   void Reset();
+
+   // Mark the cell as occupied by a block of the specified type
+   void SetCell(int32 Column, int32 Row, int32 TypeID);
+
+   // Remove the block of the specified type from the cell
+   void ClearCell(int32 Column, int32 Row, int32 TypeID);
+
+   // Find every run with at least RunSize blocks of the same type in the directions enabled by the rules. The indices
+   // (bottom-up, row major) of all cells that are part of such runs are added into OutMatched, in ascending order.
+   // The result is the same as FRunLengthKernel::FindMatches(). Returns true if at least one run has been found
+   bool FindMatches(const FMatchRules& Rules, FMatchedCellSet& OutMatched);
+
+private:
+   uint64* GetRow(int32 TypeID, int32 Row) { return &mPlane[(TypeID * mRowCount + Row) * mWordsPerRow]; }
+   const uint64* GetRow(int32 TypeID, int32 Row) const { return &mPlane[(TypeID * mRowCount + Row) * mWordsPerRow]; }
+
+   // Shift the row bits towards lower column indices, so bit N of the output holds bit N + Amount of the input
+   void ShiftDown(const uint64* Row, int32 Amount, uint64* Out) const;
+   // Shift the row bits towards higher column indices, so bit N of the output holds bit N - Amount of the input
+   void ShiftUp(const uint64* Row, int32 Amount, uint64* Out) const;
+
+   // Scan a single type plane, OR-ing every cell that belongs to a run into the mask rows
+   bool FindTypeMatches(int32 TypeID, int32 RunSize, EMatchDirection Directions);
+
+   int32 mColumnCount;
+   int32 mRowCount;
+   int32 mWordsPerRow;
+
+   // All the planes, one after the other. Plane count grows on demand as new type IDs are set
+   TArray<uint64> mPlane;
+   // How many blocks each plane currently holds, so empty planes can be skipped
+   TArray<int32> mPlaneCount;
+
+   // Scratch memory, kept between scans. The mask holds one bit per cell with the union of all runs of all types,
+   // the two scratch rows hold the run starts and shifted rows
+   TArray<uint64> mMask;
+   TArray<uint64> mScratch;
+};
@@ -0,0 +1,46 @@
+/**
+ * This source code is provided as reference/companion material for the uColumnsTutorial
+ * that can be freely found at http://www.kehomsforge.com and should not be commercialized
+ * in any form. It should remain free!
+ *
+ * By Yuri Sarudiansky
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Directions in which blocks can form matching runs
+enum class EMatchDirection : uint8
+{
+   None = 0,
+   Horizontal = 1 << 0,
+   Vertical = 1 << 1,
+   // Cells (c + i, r + i), which is the "down-left/up-right" pair
+   DiagonalUpRight = 1 << 2,
+   // Cells (c - i, r + i), which is the "up-left/down-right" pair
+   DiagonalUpLeft = 1 << 3,
+
+   Orthogonal = Horizontal | Vertical,
+   Diagonal = DiagonalUpRight | DiagonalUpLeft,
+   All = Orthogonal | Diagonal,
+};
+ENUM_CLASS_FLAGS(EMatchDirection)
+
+// What forms a match. Meant to be setup once when a game begins, the match kernel selects a code path
+// specialized to the rules at that moment
+struct FMatchRules
+{
+   FMatchRules(int32 InRunSize = 3, EMatchDirection InDirections = EMatchDirection::All)
+      : RunSize(InRunSize)
+      , Directions(InDirections)
+   {}
+
+   bool operator==(const FMatchRules& Other) const { return RunSize == Other.RunSize && Directions == Other.Directions; }
+   bool operator!=(const FMatchRules& Other) const { return !(*this == Other); }
+
+   // Minimum amount of equal blocks in a sequence to form a match
+   int32 RunSize;
+   // Directions that are checked
+   EMatchDirection Directions;
+};
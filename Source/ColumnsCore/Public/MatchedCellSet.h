@@ -0,0 +1,46 @@
+/**
+ * This source code is provided as reference/companion material for the uColumnsTutorial
+ * that can be freely found at http://www.kehomsforge.com and should not be commercialized
+ * in any form. It should remain free!
+ *
+ * By Yuri Sarudiansky
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Set of grid cell indices sized to the grid. A dense bitmap gives constant time insertion and duplicate
+// rejection while an append list keeps the inserted indices so they can be iterated and handed to events
+class COLUMNSCORE_API FMatchedCellSet
+{
+public:
+   FMatchedCellSet()
+      : mIsSorted(true)
+   {}
+
+   // Size the bitmap to hold the specified amount of cells. Any previously stored index is lost
+   void Init(int32 CellCount);
+
+   // Add the cell into the set. Returns false if it was already there
+   bool Add(int32 CellIndex);
+
+   bool Contains(int32 CellIndex) const { return (mBitmap[CellIndex / 64] & (uint64(1) << (CellIndex % 64))) != 0; }
+
+   // Remove all cells. Only the bitmap words touched by the stored indices are cleared
+   void Reset();
+
+   int32 Num() const { return mCells.Num(); }
+
+   // The stored indices, in insertion order unless Sort() has been called since the last insertion
+   const TArray<int32>& GetCells() const { return mCells; }
+
+   // Rebuild the index list in ascending order by walking the bitmap
+   void Sort();
+
+private:
+   TArray<uint64> mBitmap;
+   TArray<int32> mCells;
+
+   bool mIsSorted;
+};
@@ -0,0 +1,88 @@
+/**
+ * This source code is provided as reference/companion material for the uColumnsTutorial
+ * that can be freely found at http://www.kehomsforge.com and should not be commercialized
+ * in any form. It should remain free!
+ *
+ * By Yuri Sarudiansky
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MatchedCellSet.h"
+#include "MatchRules.h"
+
+// Instruction sets the run length kernel can be executed with
+enum class ERunKernel : uint8
+{
+   Scalar,
+   SSE2,
+   AVX2,
+};
+
+// Finds matching runs directly on a byte type plane (one type ID per cell, negative meaning empty, bottom-up,
+// row major). For each of the four directions (horizontal, vertical and both diagonals) every cell is compared
+// against its neighbor in that direction, a whole row of bytes at a time, giving an "equal to next" plane. Runs
+// of RunSize blocks are the cells where RunSize - 1 consecutive "equal to next" flags are set. All of those are
+// plain byte compare/AND/OR operations over contiguous memory, which is what the vector code paths accelerate.
+// The scalar path processes 8 cells per operation and is used whenever the CPU lacks the vector extensions.
+// The match rules are template parameters of the scanning code. Common rule sets (runs of 3, 4 and 5 blocks, with
+// and without diagonals) have dedicated instantiations that are selected once, when the rules are set.
+class COLUMNSCORE_API FRunLengthKernel
+{
+public:
+   // Selects the best kernel supported by the running CPU
+   FRunLengthKernel();
+
+   // Only the kernel selection and rules are copied, the scratch memory is not shared
+   FRunLengthKernel(const FRunLengthKernel& Other);
+   FRunLengthKernel& operator=(const FRunLengthKernel& Other);
+
+   // The fastest kernel supported by the running CPU
+   static ERunKernel GetBestSupported();
+
+   static bool IsSupported(ERunKernel Kernel);
+
+   static const TCHAR* GetName(ERunKernel Kernel);
+
+   // Request a specific kernel. If it's not supported by the CPU the best supported one is used instead
+   void SetKernel(ERunKernel Kernel);
+   ERunKernel GetKernel() const { return mKernel; }
+
+   // Set the match rules, selecting the specialized scanning code for them
+   void SetRules(const FMatchRules& Rules);
+   const FMatchRules& GetRules() const { return mRules; }
+
+   // Tell if the current rules are handled by a specialized instantiation rather than the generic one
+   bool IsSpecialized() const;
+
+   // Find every run with at least RunSize blocks of the same type in the enabled directions. The result is exactly
+   // the same as walking from every cell with FColumnsBoard::CountRun(). Indices are added into OutMatched in
+   // ascending order. Returns true if at least one run has been found
+   bool FindMatches(const int8* TypePlane, int32 ColumnCount, int32 RowCount, FMatchedCellSet& OutMatched)
+   {
+      return (this->*mFindMatches)(TypePlane, ColumnCount, RowCount, OutMatched);
+   }
+
+private:
+   typedef bool (FRunLengthKernel::*FindMatchesFunc)(const int8*, int32, int32, FMatchedCellSet&);
+
+   // The scanning code. A FixedRunSize of 0 means the rules are read from mRules at runtime
+   template <int32 FixedRunSize, EMatchDirection FixedDirections>
+   bool FindMatchesImpl(const int8* TypePlane, int32 ColumnCount, int32 RowCount, FMatchedCellSet& OutMatched);
+
+   // Flag the cells of every run going in the direction of Step (flat index distance to the next cell of the run)
+   template <int32 FixedRunSize>
+   bool FindDirection(const int8* TypePlane, int32 ColumnCount, int32 CellCount, int32 Step, int32 ExcludedColumn, int32 DynamicRunSize);
+
+   ERunKernel mKernel;
+   FMatchRules mRules;
+   FindMatchesFunc mFindMatches;
+   const struct FRunKernelOps* mOps;
+
+   // Scratch planes, padded with zeros so shifted reads never leave the allocation
+   TArray<uint8> mEqual;
+   TArray<uint8> mStart;
+   TArray<uint8> mMask;
+   int32 mPaddedCount;
+};
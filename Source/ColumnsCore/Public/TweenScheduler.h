@@ -0,0 +1,84 @@
+/**
+ * This source code is provided as reference/companion material for the uColumnsTutorial
+ * that can be freely found at http://www.kehomsforge.com and should not be commercialized
+ * in any form. It should remain free!
+ *
+ * By Yuri Sarudiansky
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/ArrayView.h"
+
+enum class ETweenEasing : uint8
+{
+   Linear,
+   EaseIn,
+   EaseOut,
+   EaseInOut,
+};
+
+// Holds every active location tween in structure of arrays form so a single linear pass updates all of them. Each
+// tween is identified by a target handle, chosen by the user (a cell index for instance), which is how the results
+// are mapped back into whatever is being animated.
+// After each Update() the targets and values of all tweens, including the ones that have just finished (holding their
+// end value), can be read. The finished ones are also listed as completed and are only removed at the next Update()
+class COLUMNSCORE_API FTweenScheduler
+{
+public:
+   FTweenScheduler()
+      : mUpdatedCount(0)
+      , mTime(0.0f)
+   {}
+
+   // Tween the target from Start to End, beginning after Delay seconds
+   void Add(int32 Target, const FVector& Start, const FVector& End, float Duration, ETweenEasing Easing = ETweenEasing::Linear, float Delay = 0.0f);
+
+   // Advance all tweens by the specified time
+   void Update(float DeltaSeconds);
+
+   // Remove every tween and reset the clock
+   void Reset();
+
+   // Reserve memory for the specified amount of tweens
+   void Reserve(int32 Count);
+
+   // Amount of tweens, including the ones completed by the last update
+   int32 Num() const { return mTarget.Num(); }
+
+   // Tell if there are tweens that have not finished yet
+   bool HasPending() const { return mTarget.Num() > mCompleted.Num(); }
+
+   TArrayView<const int32> GetTargets() const { return TArrayView<const int32>(mTarget.GetData(), mTarget.Num()); }
+   TArrayView<const FVector> GetValues() const { return TArrayView<const FVector>(mValue.GetData(), mValue.Num()); }
+
+   // Targets of the tweens finished by the last update, in no particular order
+   TArrayView<const int32> GetCompleted() const { return TArrayView<const int32>(mCompleted.GetData(), mCompleted.Num()); }
+
+   static float Ease(ETweenEasing Easing, float Alpha);
+
+private:
+   // Pack the tweens that are still running, dropping the ones reported as completed by the last update
+   void RemoveCompleted();
+
+   float GetAlpha(int32 Index) const
+   {
+      return mDuration[Index] > 0.0f ? FMath::Clamp((mTime - mStartTime[Index]) / mDuration[Index], 0.0f, 1.0f) : 1.0f;
+   }
+
+   TArray<int32> mTarget;
+   TArray<FVector> mStart;
+   TArray<FVector> mEnd;
+   TArray<float> mStartTime;
+   TArray<float> mDuration;
+   TArray<ETweenEasing> mEasing;
+   TArray<FVector> mValue;
+
+   TArray<int32> mCompleted;
+   // Amount of tweens processed by the last update. Tweens added after it are never removed before being reported
+   int32 mUpdatedCount;
+
+   // Scheduler clock. Tweens store their start time in it rather than each one counting its elapsed time
+   float mTime;
+};
@@ -9,6 +9,6 @@ public class uColumnsTutorialTarget : TargetRules
 	{
 		Type = TargetType.Game;
 
-		ExtraModuleNames.AddRange( new string[] { "uColumnsTutorial" } );
+		ExtraModuleNames.AddRange( new string[] { "uColumnsTutorial", "ColumnsCore" } );
 	}
 }
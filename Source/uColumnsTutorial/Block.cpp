@@ -11,14 +11,28 @@
 #include "Materials/MaterialInstance.h"
 #include "Materials/MaterialInstanceDynamic.h"
 
+const FName ABlock::IntensityParameter(TEXT("Intensity"));
+
 ABlock::ABlock()
 {
    PrimaryActorTick.bCanEverTick = false;
 
+   mSharedMaterial = nullptr;
+   mBlinkMaterial = nullptr;
+   mAllowInstancing = true;
+
    if (RootComponent)
    {
       RootComponent->SetMobility(EComponentMobility::Movable);
    }
+
+   // Blocks are purely visual. Without collision, moving them doesn't touch physics or overlaps
+   if (UPaperSpriteComponent* render = GetRenderComponent())
+   {
+      render->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+      render->SetGenerateOverlapEvents(false);
+      render->SetCanEverAffectNavigation(false);
+   }
 }
 
 void ABlock::InitTypeID(int32 ID)
@@ -28,8 +42,14 @@ void ABlock::InitTypeID(int32 ID)
 
 void ABlock::InitMaterial(UMaterialInterface* Material)
 {
-   mMaterial = UMaterialInstanceDynamic::Create(Material, this);
-   GetRenderComponent()->SetMaterial(0, mMaterial);
+   mSharedMaterial = Material;
+   GetRenderComponent()->SetMaterial(0, Material);
+}
+
+void ABlock::SetPoolActive(bool Active)
+{
+   SetActorHiddenInGame(!Active);
+   SetActorEnableCollision(Active);
 }
 
 bool ABlock::IsSameType(ABlock* OtherBlock) const
@@ -49,8 +69,8 @@ void ABlock::SwapWith(ABlock* OtherBlock)
 
    // Swap actor locations
    const FVector tmp_location = GetActorLocation();
-   SetActorLocation(OtherBlock->GetActorLocation());
-   OtherBlock->SetActorLocation(tmp_location);
+   SetBlockLocation(OtherBlock->GetActorLocation());
+   OtherBlock->SetBlockLocation(tmp_location);
 
    // Swap the original position
    Swap(mOriginalPosition, OtherBlock->mOriginalPosition);
@@ -58,6 +78,14 @@ void ABlock::SwapWith(ABlock* OtherBlock)
    Swap(mFinalPosition, OtherBlock->mFinalPosition);
 }
 
+void ABlock::SetBlockLocation(const FVector& Location)
+{
+   // The root is never attached, so its relative location is also the world one
+   USceneComponent* root = GetRootComponent();
+   root->RelativeLocation = Location;
+   root->UpdateComponentToWorld(EUpdateTransformFlags::SkipPhysicsUpdate, ETeleportType::TeleportPhysics);
+}
+
 bool ABlock::InterpolateHorizontal(float Alpha, float& OutCoordinate)
 {
    if (Alpha >= 1.0f)
@@ -82,9 +110,24 @@ bool ABlock::InterpolateVertical(float Alpha, float& OutCoordinate)
 
 void ABlock::SetIntensity(float Intensity)
 {
-   if (mMaterial)
+   if (!mSharedMaterial)
+      return;
+
+   // A pooled block may already hold a dynamic instance, created for a previous type
+   if (!mBlinkMaterial || mBlinkMaterial->Parent != mSharedMaterial)
    {
-      mMaterial->SetScalarParameterValue("Intensity", Intensity);
+      mBlinkMaterial = UMaterialInstanceDynamic::Create(mSharedMaterial, this);
    }
+
+   if (GetRenderComponent()->GetMaterial(0) != mBlinkMaterial)
+   {
+      GetRenderComponent()->SetMaterial(0, mBlinkMaterial);
+   }
+   mBlinkMaterial->SetScalarParameterValue(IntensityParameter, Intensity);
+}
+
+void ABlock::SetBlinkGroup(UMaterialInstanceDynamic* GroupMaterial)
+{
+   GetRenderComponent()->SetMaterial(0, GroupMaterial ? GroupMaterial : mSharedMaterial);
 }
 
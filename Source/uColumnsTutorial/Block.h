@@ -25,6 +25,9 @@ public:
    void InitTypeID(int32 ID);
    void InitMaterial(UMaterialInterface* Material);
 
+   // Show or hide the block, also toggling its collision. Used by the block pool instead of spawning/destroying
+   void SetPoolActive(bool Active);
+
    // Type query
    UFUNCTION(BlueprintPure, Category = "Block")
    bool IsSameType(ABlock* OtherBlock) const;
@@ -39,6 +42,10 @@ public:
 
    void SwapWith(ABlock* OtherBlock);
 
+   // Move the block without sweeping, overlap checks or physics updates. Blocks have no collision, so this only
+   // refreshes the component transforms, leaving the render update to the end of the frame
+   void SetBlockLocation(const FVector& Location);
+
    bool InterpolateHorizontal(float Alpha, float& OutCoordinate);
    bool InterpolateVertical(float Alpha, float& OutCoordinate);
 
@@ -47,9 +54,23 @@ public:
    void SetupHorizontal(float Coordinate) { mFinalPosition.X = Coordinate; }
    void SetupVertical(float Coordinate) { mFinalPosition.Z = Coordinate; }
 
+   // Blocks render with the shared material of their type. Changing the intensity switches the block into a
+   // private dynamic instance of that material, which is kept around for the next time it's needed
    UFUNCTION(BlueprintCallable)
    void SetIntensity(float Intensity);
 
+   // Render with a dynamic instance shared by every blinking block of the same material, so a single parameter
+   // change animates all of them. Passing null goes back to the shared material of the type
+   void SetBlinkGroup(UMaterialInstanceDynamic* GroupMaterial);
+
+   UMaterialInterface* GetSharedMaterial() const { return mSharedMaterial; }
+
+   // Tell if the block can be drawn as an instance of the play field while resting in the grid
+   bool AllowsInstancing() const { return mAllowInstancing; }
+
+   // Name of the material parameter controlling the blink
+   static const FName IntensityParameter;
+
 
    // Native C++ event called whenever this block is about to be destroyed
    virtual void OnBeingDestroyed() { BP_OnBeingDestroyed(); }
@@ -64,11 +85,51 @@ private:
    UPROPERTY()
    int32 mTypeID;
 
+   // Resting blocks may be drawn as instances, with the actor only brought back when the block blinks, is removed or
+   // falls. Turn this off in block classes that must keep their actor (and anything it does) while resting
+   UPROPERTY(EditDefaultsOnly, Category = "Block", meta = (DisplayName = "Allow Instancing", AllowPrivateAccess = true))
+   bool mAllowInstancing;
+
+   // Material of the block type, shared by every block of that type
+   UPROPERTY()
+   UMaterialInterface* mSharedMaterial;
+
+   // Only created once the block's parameters must differ from the shared material
    UPROPERTY()
-   UMaterialInstanceDynamic* mMaterial;
+   UMaterialInstanceDynamic* mBlinkMaterial;
 
    // Reference position values used to animate movement
    FVector mOriginalPosition;
    FVector mFinalPosition;
 
 };
+
+
+// Block locations gathered during a frame, applied in a single pass once all movement has been computed
+struct FBlockMoveBatch
+{
+public:
+   void Add(ABlock* Block, const FVector& Location)
+   {
+      mBlock.Add(Block);
+      mLocation.Add(Location);
+   }
+
+   // Move all blocks, leaving the batch empty but with its memory kept for the next frame
+   void Apply()
+   {
+      const int32 count = mBlock.Num();
+      for (int32 i = 0; i < count; i++)
+      {
+         mBlock[i]->SetBlockLocation(mLocation[i]);
+      }
+      mBlock.Reset();
+      mLocation.Reset();
+   }
+
+   int32 Num() const { return mBlock.Num(); }
+
+private:
+   TArray<ABlock*> mBlock;
+   TArray<FVector> mLocation;
+};
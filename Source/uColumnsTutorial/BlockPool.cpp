@@ -0,0 +1,92 @@
+/**
+ * This source code is provided as reference/companion material for the uColumnsTutorial
+ * that can be freely found at http://www.kehomsforge.com and should not be commercialized
+ * in any form. It should remain free!
+ *
+ * By Yuri Sarudiansky
+ */
+
+#include "BlockPool.h"
+
+
+bool FBlockPool::AddInactive(UWorld* World, UClass* BlockClass)
+{
+   if (!World || !BlockClass)
+      return false;
+
+   const FTransform spawn_transform;
+   ABlock* block = World->SpawnActorDeferred<ABlock>(BlockClass, spawn_transform);
+   if (!block)
+      return false;
+
+   block->FinishSpawning(spawn_transform);
+   block->SetPoolActive(false);
+   GetBucket(BlockClass).Free.Add(block);
+   return true;
+}
+
+void FBlockPool::Release(ABlock* Block)
+{
+   if (!Block || Block->IsPendingKill())
+      return;
+
+   Block->SetPoolActive(false);
+   GetBucket(Block->GetClass()).Free.Add(Block);
+}
+
+void FBlockPool::Empty()
+{
+   for (FBlockPoolBucket& bucket : mBucket)
+   {
+      DestroyBlocks(bucket);
+   }
+   mBucket.Empty();
+}
+
+void FBlockPool::EmptyExcept(const TArray<UClass*>& KeepClasses)
+{
+   for (int32 i = mBucket.Num() - 1; i >= 0; i--)
+   {
+      if (!KeepClasses.Contains(mBucket[i].BlockClass))
+      {
+         DestroyBlocks(mBucket[i]);
+         mBucket.RemoveAtSwap(i, 1, false);
+      }
+   }
+}
+
+int32 FBlockPool::GetFreeCount(UClass* BlockClass) const
+{
+   for (const FBlockPoolBucket& bucket : mBucket)
+   {
+      if (bucket.BlockClass == BlockClass)
+         return bucket.Free.Num();
+   }
+   return 0;
+}
+
+FBlockPoolBucket& FBlockPool::GetBucket(UClass* BlockClass)
+{
+   // Themes use very few block classes, so a linear search is enough
+   for (FBlockPoolBucket& bucket : mBucket)
+   {
+      if (bucket.BlockClass == BlockClass)
+         return bucket;
+   }
+
+   FBlockPoolBucket& bucket = mBucket[mBucket.AddDefaulted()];
+   bucket.BlockClass = BlockClass;
+   return bucket;
+}
+
+void FBlockPool::DestroyBlocks(FBlockPoolBucket& Bucket)
+{
+   for (ABlock* block : Bucket.Free)
+   {
+      if (block && !block->IsPendingKill())
+      {
+         block->Destroy();
+      }
+   }
+   Bucket.Free.Empty();
+}
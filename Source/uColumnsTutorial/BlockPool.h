@@ -0,0 +1,91 @@
+/**
+ * This source code is provided as reference/companion material for the uColumnsTutorial
+ * that can be freely found at http://www.kehomsforge.com and should not be commercialized
+ * in any form. It should remain free!
+ *
+ * By Yuri Sarudiansky
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/World.h"
+#include "Block.h"
+#include "BlockPool.generated.h"
+
+// Deactivated blocks of a single class
+USTRUCT()
+struct FBlockPoolBucket
+{
+   GENERATED_USTRUCT_BODY()
+public:
+   FBlockPoolBucket()
+      : BlockClass(nullptr)
+   {}
+
+   UPROPERTY()
+   UClass* BlockClass;
+
+   UPROPERTY()
+   TArray<ABlock*> Free;
+};
+
+
+// Keeps block actors alive once they are removed from the game so they can be reused instead of spawning new ones.
+// Deactivated blocks are hidden, without collision, and are kept per class since a theme may use custom block
+// classes. The owner is meant to be the game mode, so there is one pool per world
+USTRUCT()
+struct UCOLUMNSTUTORIAL_API FBlockPool
+{
+   GENERATED_USTRUCT_BODY()
+public:
+   // Spawn a single deactivated block of the class into the pool. Meant to be called a few times per frame when
+   // filling the pool ahead of time, rather than spawning a whole grid worth of actors at once
+   bool AddInactive(UWorld* World, UClass* BlockClass);
+
+   // Take a block of the class, spawning a new one if none is available. InitFunc(ABlock*) is called before the
+   // block is activated, which for new blocks means before the construction script runs
+   template <typename InitFunc>
+   ABlock* Acquire(UWorld* World, UClass* BlockClass, const FTransform& Transform, InitFunc Init)
+   {
+      FBlockPoolBucket& bucket = GetBucket(BlockClass);
+      while (bucket.Free.Num() > 0)
+      {
+         ABlock* block = bucket.Free.Pop(false);
+         if (!block || block->IsPendingKill())
+            continue;
+
+         block->SetActorTransform(Transform, false, nullptr, ETeleportType::TeleportPhysics);
+         Init(block);
+         block->SetPoolActive(true);
+         return block;
+      }
+
+      ABlock* block = World ? World->SpawnActorDeferred<ABlock>(BlockClass, Transform) : nullptr;
+      if (block)
+      {
+         Init(block);
+         block->FinishSpawning(Transform);
+      }
+      return block;
+   }
+
+   // Deactivate the block and keep it for later reuse
+   void Release(ABlock* Block);
+
+   // Destroy every block held by the pool
+   void Empty();
+
+   // Destroy the blocks held for classes other than the specified ones, such as the ones of a previous theme
+   void EmptyExcept(const TArray<UClass*>& KeepClasses);
+
+   int32 GetFreeCount(UClass* BlockClass) const;
+
+private:
+   FBlockPoolBucket& GetBucket(UClass* BlockClass);
+
+   void DestroyBlocks(FBlockPoolBucket& Bucket);
+
+   UPROPERTY()
+   TArray<FBlockPoolBucket> mBucket;
+};
@@ -0,0 +1,71 @@
+/**
+ * This source code is provided as reference/companion material for the uColumnsTutorial
+ * that can be freely found at http://www.kehomsforge.com and should not be commercialized
+ * in any form. It should remain free!
+ *
+ * By Yuri Sarudiansky
+ */
+
+#include "BlockWorkQueue.h"
+#include "Block.h"
+
+
+void FBlockWorkQueue::AddSpawn(int32 CellIndex, int32 TypeID)
+{
+   FBlockWork& work = mWork[mWork.AddDefaulted()];
+   work.CellIndex = CellIndex;
+   work.TypeID = TypeID;
+}
+
+void FBlockWorkQueue::AddRelease(ABlock* Block)
+{
+   if (!Block)
+      return;
+
+   FBlockWork& work = mWork[mWork.AddDefaulted()];
+   work.Block = Block;
+}
+
+void FBlockWorkQueue::AddPrewarm(UClass* BlockClass, int32 Count)
+{
+   if (!BlockClass)
+      return;
+
+   for (int32 i = 0; i < Count; i++)
+   {
+      FBlockWork& work = mWork[mWork.AddDefaulted()];
+      work.BlockClass = BlockClass;
+   }
+}
+
+void FBlockWorkQueue::CancelSpawns()
+{
+   int32 write = mHead;
+   for (int32 read = mHead; read < mWork.Num(); read++)
+   {
+      if (mWork[read].Block)
+      {
+         mWork[write++] = mWork[read];
+      }
+   }
+   mWork.SetNum(write, false);
+
+   if (IsIdle())
+   {
+      mWork.Reset();
+      mHead = 0;
+   }
+}
+
+int32 FBlockWorkQueue::GetPendingReleaseCount(UClass* BlockClass) const
+{
+   int32 count = 0;
+   for (int32 i = mHead; i < mWork.Num(); i++)
+   {
+      if (mWork[i].Block && mWork[i].Block->GetClass() == BlockClass)
+      {
+         count++;
+      }
+   }
+   return count;
+}
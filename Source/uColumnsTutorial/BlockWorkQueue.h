@@ -0,0 +1,107 @@
+/**
+ * This source code is provided as reference/companion material for the uColumnsTutorial
+ * that can be freely found at http://www.kehomsforge.com and should not be commercialized
+ * in any form. It should remain free!
+ *
+ * By Yuri Sarudiansky
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformTime.h"
+#include "BlockWorkQueue.generated.h"
+
+// A block actor waiting to be sent back into the pool (Block is set), to be spawned into the pool (BlockClass is set)
+// or to be spawned into a cell
+USTRUCT()
+struct FBlockWork
+{
+   GENERATED_USTRUCT_BODY()
+public:
+   FBlockWork()
+      : Block(nullptr)
+      , BlockClass(nullptr)
+      , CellIndex(-1)
+      , TypeID(-1)
+   {}
+
+   UPROPERTY()
+   class ABlock* Block;
+
+   UPROPERTY()
+   UClass* BlockClass;
+
+   int32 CellIndex;
+   int32 TypeID;
+};
+
+
+// Spreads the spawning and releasing of block actors over several frames, including filling the block pool before a
+// game. The grid data is meant to be updated right away by the owner, only the actor work is queued. Each Process() call handles the items in the order they were
+// added until the time budget is used, always handling at least one so the queue drains even with a tiny budget
+USTRUCT()
+struct UCOLUMNSTUTORIAL_API FBlockWorkQueue
+{
+   GENERATED_USTRUCT_BODY()
+public:
+   FBlockWorkQueue()
+      : mHead(0)
+   {}
+
+   void AddSpawn(int32 CellIndex, int32 TypeID);
+   void AddRelease(class ABlock* Block);
+   void AddPrewarm(UClass* BlockClass, int32 Count);
+
+   // Drop the spawns and prewarms that were not handled yet. Releases are kept since their actors are no longer in the grid
+   void CancelSpawns();
+
+   // Amount of blocks of the class waiting to be sent back into the pool
+   int32 GetPendingReleaseCount(UClass* BlockClass) const;
+
+   bool IsIdle() const { return mHead >= mWork.Num(); }
+
+   int32 GetPendingCount() const { return mWork.Num() - mHead; }
+
+   // Handle queued items until BudgetSeconds have passed, calling SpawnFunc(CellIndex, TypeID), ReleaseFunc(ABlock*)
+   // or PrewarmFunc(UClass*). Returns true when this call completed the batch, that is, the queue became idle
+   template <typename SpawnFunc, typename ReleaseFunc, typename PrewarmFunc>
+   bool Process(double BudgetSeconds, SpawnFunc Spawn, ReleaseFunc Release, PrewarmFunc Prewarm)
+   {
+      if (IsIdle())
+         return false;
+
+      const double end_time = FPlatformTime::Seconds() + BudgetSeconds;
+      do
+      {
+         const FBlockWork& work = mWork[mHead++];
+         if (work.Block)
+         {
+            Release(work.Block);
+         }
+         else if (work.BlockClass)
+         {
+            Prewarm(work.BlockClass);
+         }
+         else
+         {
+            Spawn(work.CellIndex, work.TypeID);
+         }
+      } while (!IsIdle() && FPlatformTime::Seconds() < end_time);
+
+      if (IsIdle())
+      {
+         mWork.Reset();
+         mHead = 0;
+         return true;
+      }
+      return false;
+   }
+
+private:
+   UPROPERTY()
+   TArray<FBlockWork> mWork;
+
+   // Index of the next item to be handled. Handled items are only removed once the batch completes
+   int32 mHead;
+};
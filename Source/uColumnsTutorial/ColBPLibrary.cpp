@@ -79,12 +79,13 @@ void UColBPLibrary::GetThemeCollection(TArray<class UThemeData*>& OutThemeCollec
 FLinearColor UColBPLibrary::GetParticlesColor(const class ABlock* Block, const UObject* WorldContextObject)
 {
    FLinearColor retval = FLinearColor(1.0f, 1.0f, 1.0f, 1.0f);
-   if (UThemeData* theme = GetGameTheme(WorldContextObject))
+   if (UColGameInstance* gi = GetColGameInstance(WorldContextObject))
    {
+      const FThemeTable& theme_table = gi->GetThemeTable();
       const int32 block_id = Block->GetTypeID();
-      if (block_id < theme->BlockCollection.Num())
+      if (theme_table.IsValidType(block_id))
       {
-         retval = theme->BlockCollection[block_id].ParticlesColor;
+         retval = theme_table[block_id].ParticlesColor;
       }
    }
    return retval;
@@ -108,6 +109,23 @@ int32 UColBPLibrary::GetMinimumMatchRunSize(const UObject* WorldContextObject)
    return 3;
 }
 
+void UColBPLibrary::SetMatchDiagonal(const UObject* WorldContextObject, bool Enabled)
+{
+   if (UColGameInstance* gi = GetColGameInstance(WorldContextObject))
+   {
+      gi->SetMatchDiagonal(Enabled);
+   }
+}
+
+bool UColBPLibrary::GetMatchDiagonal(const UObject* WorldContextObject)
+{
+   if (UColGameInstance* gi = GetColGameInstance(WorldContextObject))
+   {
+      return gi->GetMatchDiagonal();
+   }
+   return true;
+}
+
 void UColBPLibrary::SetPlayerPieceSize(const UObject* WorldContextObject, int32 NewSize)
 {
    if (UColGameInstance* gi = GetColGameInstance(WorldContextObject))
@@ -351,6 +369,15 @@ FSlateBrush UColBPLibrary::GetBlockBrush(class UThemeData* Theme, int32 TypeID,
          return ret;
       }
    }
+   else if (Theme->HasBlockAtlas())
+   {
+      // Use the same atlas as the blocks in the grid so the HUD images batch as well
+      FSlateBrush ret;
+      ret.SetResourceObject(Theme->BlockAtlas);
+      ret.SetUVRegion(Theme->GetBlockAtlasUV(TypeID));
+      ret.ImageSize = FVector2D(DrawSize, DrawSize);
+      return ret;
+   }
    else
    {
       if (class UMaterialInterface* mat = Theme->BlockCollection[TypeID].Material)
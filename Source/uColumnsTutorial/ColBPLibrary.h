@@ -47,6 +47,14 @@ public:
    UFUNCTION(BlueprintPure, meta = (WorldContext = "WorldContextObject"))
    static int32 GetMinimumMatchRunSize(const UObject* WorldContextObject);
 
+   // Set if diagonal sequences form matches
+   UFUNCTION(BlueprintCallable, meta = (WorldContext = "WorldContextObject"))
+   static void SetMatchDiagonal(const UObject* WorldContextObject, bool Enabled);
+
+   // Obtain if diagonal sequences form matches
+   UFUNCTION(BlueprintPure, meta = (WorldContext = "WorldContextObject"))
+   static bool GetMatchDiagonal(const UObject* WorldContextObject);
+
    // Set the player piece size
    UFUNCTION(BlueprintCallable, meta = (WorldContext = "WorldContextObject"))
    static void SetPlayerPieceSize(const UObject* WorldContextObject, int32 NewSize);
@@ -15,6 +15,7 @@ UColGameInstance::UColGameInstance()
 {
    mTheme = nullptr;
    mMatchRunSize = 3;
+   mMatchDiagonal = true;
    mPlayerPieceSize = 3;
    mShiftDelay = 0.2f;
    mSideMoveDelay = 0.35f;
@@ -32,6 +33,9 @@ void UColGameInstance::Init()
 {
    Super::Init();
 
+   // The theme may have been set as a default property rather than selected
+   mThemeTable.Build(mTheme);
+
    // Register the on viewport resize event to our function and store the delegate handle
    mViewportHandle = FViewport::ViewportResizedEvent.AddUObject(this, &UColGameInstance::OnViewportResize);
 }
@@ -46,6 +50,23 @@ void UColGameInstance::Shutdown()
 }
 
 
+FColRuleSet UColGameInstance::GetRuleSet() const
+{
+   FColRuleSet rules;
+   rules.MatchRunSize = mMatchRunSize;
+   rules.MatchDiagonal = mMatchDiagonal;
+   rules.PlayerPieceSize = mPlayerPieceSize;
+   rules.ShiftDelay = mShiftDelay;
+   rules.SideMoveDelay = mSideMoveDelay;
+   rules.HorizontalMoveTime = mHorizontalMoveTime;
+   rules.VerticalMoveTime = mVerticalMoveTime;
+   rules.VerticalFastMultiplier = mVerticalFastMultiplier;
+   rules.RepositionMoveTime = mRepositionMoveTime;
+   rules.BlinkingSpeed = mBlinkingSpeed;
+   rules.BlinkingTime = mBlinkingTime;
+   return rules;
+}
+
 void UColGameInstance::OnViewportResize(FViewport* Viewport, uint32 ID)
 {
    // Broadcast to any bound function
@@ -9,6 +9,8 @@
 #pragma once
 
 #include "Engine/GameInstance.h"
+#include "helpers.h"
+#include "ThemeData.h"
 #include "ColGameInstance.generated.h"
 
 
@@ -35,17 +37,26 @@ public:
 
    class UThemeData* GetTheme() const { return mTheme; }
 
-   void SetTheme(class UThemeData* NewTheme) { mTheme = NewTheme; }
+   void SetTheme(class UThemeData* NewTheme) { mTheme = NewTheme; mThemeTable.Build(NewTheme); }
+
+   // The current theme, compiled for per block lookups
+   const FThemeTable& GetThemeTable() const { return mThemeTable; }
 
    UFUNCTION(BlueprintPure)
    int32 GetMinimumMatchRunSize() const { return mMatchRunSize; }
 
    UFUNCTION(BlueprintCallable)
-   void SetMinimumMatchRunSize(int32 RunSize) { mMatchRunSize = RunSize; }
+   void SetMinimumMatchRunSize(int32 RunSize) { mMatchRunSize = RunSize; mOnRulesChanged.Broadcast(); }
+
+   UFUNCTION(BlueprintPure)
+   bool GetMatchDiagonal() const { return mMatchDiagonal; }
+
+   UFUNCTION(BlueprintCallable)
+   void SetMatchDiagonal(bool Enabled) { mMatchDiagonal = Enabled; mOnRulesChanged.Broadcast(); }
 
    int32 GetPlayerPieceSize() const { return mPlayerPieceSize; }
 
-   void SetPlayerPieceSize(int32 Size) { mPlayerPieceSize = Size; }
+   void SetPlayerPieceSize(int32 Size) { mPlayerPieceSize = Size; mOnRulesChanged.Broadcast(); }
 
    UFUNCTION(BlueprintPure)
    float GetShiftDelay() const { return mShiftDelay; }
@@ -72,6 +83,12 @@ public:
    UFUNCTION(BlueprintPure)
    float GetBlinkingTime() const { return mBlinkingTime; }
 
+   // Copy all the gameplay settings at once
+   FColRuleSet GetRuleSet() const;
+
+   // Fired whenever one of the gameplay settings is changed, so copies of the rule set can be refreshed
+   FSimpleMulticastDelegate& OnRulesChanged() { return mOnRulesChanged; }
+
 
 
 private:
@@ -87,10 +104,17 @@ private:
    UPROPERTY(EditAnywhere, meta = (AllowPrivateAccess = true))
    class UThemeData* mTheme;
 
+   UPROPERTY()
+   FThemeTable mThemeTable;
+
    // Defines the minimum matching sequence size
    UPROPERTY(EditAnywhere, meta = (DisplayName = "Match Run Size"))
    int32 mMatchRunSize;
 
+   // Defines if diagonal sequences also form matches
+   UPROPERTY(EditAnywhere, meta = (DisplayName = "Match Diagonal"))
+   bool mMatchDiagonal;
+
    UPROPERTY(EditAnywhere, meta = (DisplayName = "Player Piece Size"))
    int32 mPlayerPieceSize;
 
@@ -121,6 +145,8 @@ private:
 
 
 
+   FSimpleMulticastDelegate mOnRulesChanged;
+
    // Holds information necessary to un-register the OnViewportResize function from the ViewportResizeEvent delegate.
    FDelegateHandle mViewportHandle;
 
@@ -30,12 +30,11 @@ void AGMInGameTraditional::CustomGameInit(float Seconds)
             block_type = PickRandomBlock();
          }
 
-         SpawnBlock(col, row, block_type, true);
+         // Adding the block into the grid also updates the floor level of the column. The actor is spawned later
+         QueueBlock(col, row, block_type);
       }
    }
 
-   CheckGridFloorLevels();
-
    mSpeedProgress = 0.0f;
 
    Super::CustomGameInit(Seconds);
@@ -50,7 +49,7 @@ bool AGMInGameTraditional::IsGameLost()
    const int32 rows_left = GetRowCount() - GetFloor(spawn_col);
 
    // Game is lost is rows left is smaller than the player piece size
-   return (rows_left < UColBPLibrary::GetPlayerPieceSize(this));
+   return (rows_left < GetRuleSet().PlayerPieceSize);
 }
 
 float AGMInGameTraditional::OnGetVerticalMoveTime_Internal() const
@@ -60,7 +59,7 @@ float AGMInGameTraditional::OnGetVerticalMoveTime_Internal() const
       return mSpeedCurve->GetFloatValue(mSpeedProgress);
    }
 
-   return UColBPLibrary::GetVerticalMoveTime(this);
+   return GetRuleSet().VerticalMoveTime;
 }
 
 void AGMInGameTraditional::OnPlayerPieceLanded(const TArray<int32>& BlockIndices)
@@ -74,17 +73,6 @@ void AGMInGameTraditional::OnPlayerPieceLanded(const TArray<int32>& BlockIndices
 
 bool AGMInGameTraditional::SpawnAllowed(int32 Column, int32 Row, int32 TypeID) const
 {
-   // The minimum match run size
-   const int32 match_run = UColBPLibrary::GetMinimumMatchRunSize(this);
-
-
-   if (GetLeftMatch(Column, Row, TypeID) + 1 >= match_run)
-      return false;
-   if (GetDownRightMatch(Column, Row, TypeID) + 1 >= match_run)
-      return false;
-   if (GetDownMatch(Column, Row, TypeID) + 1 >= match_run)
-      return false;
-   if (GetDownLeftMatch(Column, Row, TypeID) + 1 >= match_run)
-      return false;
-   return true;
+   // Uses the match rules setup when the game was initialized
+   return !GetBoard().FormsRun(Column, Row, TypeID);
 }
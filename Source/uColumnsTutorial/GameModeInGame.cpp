@@ -49,9 +49,23 @@ AGameModeInGame::AGameModeInGame()
 
    mScorePerBlock = 5.0f;
    mChainedMultiDelta = 1.0f;
+   mLocalMatchBase = FColumnsBoard::DefaultLocalMatchBase;
+   mLocalMatchDensity = FColumnsBoard::DefaultLocalMatchDensity;
+   mUseInstancedBlocks = false;
+   mBlockWorkBudget = 2.0f;
+   mDeferGarbageCollection = true;
+   mGarbageMemoryCeiling = 1024.0f;
+   mGarbageBlinkWindow = 0.3f;
+   mShatterParticles = nullptr;
+   mShatterPoolSize = 8;
+   mShatterBurstsPerFrame = 4;
+   mShatterMaxScale = 2.0f;
    mCurrentBonusMultiplier = 1.0f;
+   mCascadeWave = 0;
 
    mInitialCountdown = 5;
+   mRandomSeed = 0;
+   mRulesDirty = true;
 }
 
 void AGameModeInGame::OnConstruction(const FTransform& Transform)
@@ -96,32 +110,15 @@ void AGameModeInGame::OnConstruction(const FTransform& Transform)
       pf->RebuildGridMap();
    }
 
-   // Initialize block management array
+   // Initialize block management data
    const int32 cell_count = mGridColumnCount * mGridRowCount;
-   mGridData.Empty(cell_count);
-   mGridData.AddDefaulted(mGridData.Max());
+   mBoard.Init(mGridColumnCount, mGridRowCount);
+   mBlockActor.Init(nullptr, cell_count);
+   mRepositioningBlock.Init(nullptr, cell_count);
+   mTween.Reserve(cell_count);
 
-   int32 row = mGridRowCount - 1;
-   int32 col = 0;
-   for (int32 data_index = 0; data_index < cell_count; data_index++)
-   {
-      mGridData[data_index] = FGridCellData(col, row);
-
-      if (++col == mGridColumnCount)
-      {
-         col = 0;
-         row--;
-      }
-   }
-
-   // Initialize the mColumnFloor array
-   mColumnFloor.SetNum(mGridColumnCount);
-
-   // Probably not necessary, but making sure of this value should avoid some unpleasant bugs
-   for (int32 i = 0; i < mGridColumnCount; i++)
-   {
-      mColumnFloor[i] = 0;
-   }
+   // The matched cells set must be able to hold the entire grid
+   mMatchedBlock.Init(cell_count);
 
    // Obtain the PlayField pointer
    TActorIterator<APlayField> it(GetWorld());
@@ -140,6 +137,14 @@ void AGameModeInGame::BeginPlay()
 
    mCurrentState = &AGameModeInGame::StateGameInit;
 
+   mGarbageScheduler.Init(mDeferGarbageCollection, mGarbageMemoryCeiling);
+
+   if (UColGameInstance* gi = UColBPLibrary::GetColGameInstance(this))
+   {
+      mRulesChangedHandle = gi->OnRulesChanged().AddUObject(this, &AGameModeInGame::InvalidateRuleSet);
+   }
+   RefreshRuleSet();
+
    // Setup input handling
    if (UWorld* const world = GetWorld())
    {
@@ -159,6 +164,43 @@ void AGameModeInGame::BeginPlay()
    }
 }
 
+void AGameModeInGame::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+   mGarbageScheduler.Shutdown();
+
+   // Pooled blocks are hidden but still part of the level, nothing else will ever take them
+   mBlockPool.Empty();
+
+   if (UColGameInstance* gi = UColBPLibrary::GetColGameInstance(this))
+   {
+      gi->OnRulesChanged().Remove(mRulesChangedHandle);
+   }
+
+   Super::EndPlay(EndPlayReason);
+}
+
+void AGameModeInGame::InvalidateRuleSet()
+{
+   // The board and pieces are setup from the settings when a game begins, so changes wait until then
+   mRulesDirty = true;
+}
+
+void AGameModeInGame::RefreshRuleSet()
+{
+   if (!mRulesDirty)
+      return;
+
+   mRulesDirty = false;
+   if (UColGameInstance* gi = UColBPLibrary::GetColGameInstance(this))
+   {
+      mRules = gi->GetRuleSet();
+   }
+   else
+   {
+      mRules = FColRuleSet();
+   }
+}
+
 void AGameModeInGame::Tick(float DeltaTime)
 {
    Super::Tick(DeltaTime);
@@ -176,6 +218,16 @@ void AGameModeInGame::Tick(float DeltaTime)
       }
 
       mCurrentState = (this->*mCurrentState)(DeltaTime);
+
+      // Move every block that had its location changed by the state
+      mMoveBatch.Apply();
+
+      // Start the effects allowed for this frame, leaving the rest for the next ones
+      mShatterEffects.Tick(mShatterBurstsPerFrame);
+
+      ProcessBlockWork();
+
+      mGarbageScheduler.Tick(IsActivePlayState());
    }
 }
 
@@ -184,39 +236,141 @@ void AGameModeInGame::Tick(float DeltaTime)
 
 void AGameModeInGame::CalculateWeightSum()
 {
-   // Make sure it begins with a "clean" value
-   mWeightSum = 0.0f;
-   if (UThemeData* theme = UColBPLibrary::GetGameTheme(this))
+   // From here on per block lookups only index this copy
+   if (UColGameInstance* gi = UColBPLibrary::GetColGameInstance(this))
    {
-      for (const FBlockData& bdata : theme->BlockCollection)
-      {
-         mWeightSum += bdata.ProbabilityWeight;
-      }
+      mThemeTable = gi->GetThemeTable();
+   }
+   else
+   {
+      mThemeTable = FThemeTable();
    }
+
+   TArray<float> weights;
+   weights.Reserve(mThemeTable.Num());
+   for (int32 type_id = 0; type_id < mThemeTable.Num(); type_id++)
+   {
+      weights.Add(mThemeTable[type_id].Weight);
+   }
+   mBlockPicker.SetWeights(weights);
+   mWeightSum = mBlockPicker.GetWeightSum();
 }
 
-int32 AGameModeInGame::PickRandomBlock() const
+void AGameModeInGame::PrepareNextPiece()
 {
-   if (UThemeData* theme = UColBPLibrary::GetGameTheme(this))
+   const int32 spawn_row = GetRowCount() - mNextBlock.Num();
+   const int32 spawn_col = GetColumnCount() / 2;
+
+   if (mNextPieceBlock.Num() != mNextBlock.Num())
    {
-      const float roll = FMath::FRandRange(0.0f, mWeightSum);
-      float accumulated = 0.0f;
+      ReleaseNextPiece();
+      mNextPieceBlock.Init(nullptr, mNextBlock.Num());
+   }
 
-      for (int32 i = 0; i < theme->BlockCollection.Num(); i++)
+   for (int32 i = 0; i < mNextBlock.Num(); i++)
+   {
+      if (!mNextPieceBlock[i] && mNextBlock[i] >= 0)
       {
-         accumulated += theme->BlockCollection[i].ProbabilityWeight;
-         if (roll <= accumulated)
-            return i;
+         // Fully initialized at the spawn location, just hidden until the piece is spawned
+         if (ABlock* block = SpawnBlock(spawn_col, spawn_row + i, mNextBlock[i], false))
+         {
+            block->SetPoolActive(false);
+            mNextPieceBlock[i] = block;
+         }
       }
    }
-   return -1;
 }
 
-ABlock* AGameModeInGame::SpawnBlock(int32 Column, int32 Row, int32 TypeID, bool AddToGrid)
+void AGameModeInGame::ReleaseNextPiece()
+{
+   for (int32 i = 0; i < mNextPieceBlock.Num(); i++)
+   {
+      mBlockPool.Release(mNextPieceBlock[i]);
+      mNextPieceBlock[i] = nullptr;
+   }
+}
+
+void AGameModeInGame::QueueBlock(int32 Column, int32 Row, int32 TypeID)
+{
+   const int32 cell_index = GetCellIndex(Column, Row);
+   if (!mBoard.IsValidIndex(cell_index))
+      return;
+
+   // Rules such as SpawnAllowed() only look at the grid data, so it must be up to date before the actor exists
+   mBoard.SetCell(cell_index, TypeID);
+   mBlockWork.AddSpawn(cell_index, TypeID);
+}
+
+void AGameModeInGame::ProcessBlockWork()
+{
+   auto spawn = [this](int32 CellIndex, int32 TypeID)
+   {
+      // The cell may have been cleared or taken since the block was queued
+      if (mBoard.GetType(CellIndex) != TypeID || mBlockActor[CellIndex] || (mPlayField && mPlayField->HasBlockInstance(CellIndex)))
+         return;
+
+      SpawnBlock(CellIndex % mGridColumnCount, CellIndex / mGridColumnCount, TypeID, true);
+   };
+
+   auto release = [this](ABlock* Block)
+   {
+      mBlockPool.Release(Block);
+   };
+
+   auto prewarm = [this](UClass* BlockClass)
+   {
+      mBlockPool.AddInactive(GetWorld(), BlockClass);
+   };
+
+   mBlockWork.Process(mBlockWorkBudget * 0.001, spawn, release, prewarm);
+}
+
+bool AGameModeInGame::IsActivePlayState() const
+{
+   return mCurrentState == &AGameModeInGame::StateSpawning ||
+          mCurrentState == &AGameModeInGame::StatePlaytime ||
+          mCurrentState == &AGameModeInGame::StateCheckMatch ||
+          mCurrentState == &AGameModeInGame::StateRemovingBlock ||
+          mCurrentState == &AGameModeInGame::StateCheckPlayfield ||
+          mCurrentState == &AGameModeInGame::StateRepositioning;
+}
+
+void AGameModeInGame::PrewarmBlockPool()
 {
-   UThemeData* theme = UColBPLibrary::GetGameTheme(this);
+   if (mThemeTable.Num() == 0 || mWeightSum <= 0.0f)
+      return;
+
+   // Blocks from the player piece and the prepared next piece are alive along with the grid ones
+   const int32 block_count = mBoard.GetCellCount() + 2 * mRules.PlayerPieceSize;
+
+   // Split the blocks among the classes used by the theme according to how often each one is picked
+   TMap<UClass*, float> class_weight;
+   for (int32 type_id = 0; type_id < mThemeTable.Num(); type_id++)
+   {
+      class_weight.FindOrAdd(mThemeTable[type_id].BlockClass) += mThemeTable[type_id].Weight;
+   }
+
+   // Blocks kept for classes the theme no longer uses would never be taken again
+   TArray<UClass*> theme_classes;
+   class_weight.GetKeys(theme_classes);
+   mBlockPool.EmptyExcept(theme_classes);
+
+   for (const TPair<UClass*, float>& it : class_weight)
+   {
+      const int32 target = FMath::CeilToInt(block_count * it.Value / mWeightSum);
+      const int32 available = mBlockPool.GetFreeCount(it.Key) + mBlockWork.GetPendingReleaseCount(it.Key);
+      mBlockWork.AddPrewarm(it.Key, target - available);
+   }
+}
+
+int32 AGameModeInGame::PickRandomBlock() const
+{
+   return mBlockPicker.Pick(mRandomStream);
+}
 
-   if (TypeID >= theme->BlockCollection.Num())
+ABlock* AGameModeInGame::SpawnBlock(int32 Column, int32 Row, int32 TypeID, bool AddToGrid)
+{
+   if (!mThemeTable.IsValidType(TypeID))
    {
       return nullptr;
    }
@@ -233,8 +387,9 @@ ABlock* AGameModeInGame::SpawnBlock(int32 Column, int32 Row, int32 TypeID, bool
 
    if (world && mPlayField)
    {
-      // A shortcut to the block data
-      const FBlockData& block_data = theme->BlockCollection[TypeID];
+      // A shortcut to the block type data
+      const FThemeTypeEntry& type_entry = mThemeTable[TypeID];
+      UPaperSprite* const block_sprite = mThemeTable.BlockSprite;
 
       // Obtain the spawn location, already shifted towards the camera
       const FVector location = GetCellLocation(data_index) + FVector(0, 1, 0);
@@ -242,21 +397,23 @@ ABlock* AGameModeInGame::SpawnBlock(int32 Column, int32 Row, int32 TypeID, bool
       // The transform, necessary to spawn the actor
       FTransform spawn_transform(FRotator(0, 0, 0), location);
 
-      // Start the spawn process
-      ABlock* block = world->SpawnActorDeferred<ABlock>(block_data.BlockClass, spawn_transform);
+      const float map_scale = mPlayField->GetMapScale();
 
-      if (block)
+      // Reuse a block from the pool if there is one, otherwise a new one is spawned. Either way it's initialized before activation
+      ABlock* block = mBlockPool.Acquire(world, type_entry.BlockClass, spawn_transform, [&](ABlock* Block)
       {
-         // Initialize the block
-         block->InitTypeID(TypeID);
-         block->InitMaterial(block_data.Material);
+         Block->InitTypeID(TypeID);
 
-         block->GetRenderComponent()->SetSprite(theme->BlockSprite);
-         block->GetRenderComponent()->SetRelativeScale3D(FVector(mPlayField->GetMapScale()));
+         // The table has already resolved the atlas. With one, every block shares its material and the sprite color selects the cell
+         Block->InitMaterial(type_entry.Material);
+         Block->GetRenderComponent()->SetSpriteColor(type_entry.SpriteColor);
 
-         // Finalize actor spawning (construct)
-         UGameplayStatics::FinishSpawningActor(block, spawn_transform);
+         Block->GetRenderComponent()->SetSprite(block_sprite);
+         Block->GetRenderComponent()->SetRelativeScale3D(FVector(map_scale));
+      });
 
+      if (block)
+      {
          retval = block;
 
          if (AddToGrid)
@@ -281,7 +438,7 @@ int32 AGameModeInGame::GetCellIndex(int32 Column, int32 Row) const
 
 void AGameModeInGame::GetColumnRowFromCellIndex(int32 CellIndex, int32& OutColumn, int32& OutRow) const
 {
-   if (CellIndex >= 0 && CellIndex < mGridData.Num())
+   if (mBoard.IsValidIndex(CellIndex))
    {
       OutColumn = CellIndex % GetColumnCount();
       OutRow = CellIndex / GetColumnCount();
@@ -296,235 +453,198 @@ void AGameModeInGame::GetColumnRowFromCellIndex(int32 CellIndex, int32& OutColum
 
 void AGameModeInGame::AddBlockToGridData(int32 CellIndex, class ABlock* Block)
 {
-   if (CellIndex < mGridData.Num())
+   if (mBoard.IsValidIndex(CellIndex))
    {
-      mGridData[CellIndex].BlockActor = Block;
+      if (Block)
+      {
+         // The type is read from the actor only once, when the block is placed. This also raises the floor
+         mBoard.SetCell(CellIndex, Block->GetTypeID());
+
+         if (CanInstanceBlock(Block))
+         {
+            // Resting blocks don't need an actor, draw an instance and hand the actor back to the pool
+            mPlayField->SetBlockInstance(CellIndex, Block->GetTypeID(), GetCellLocation(CellIndex) + FVector(0, 1, 0));
+            mBlockPool.Release(Block);
+            mBlockActor[CellIndex] = nullptr;
+         }
+         else
+         {
+            mBlockActor[CellIndex] = Block;
+         }
+      }
+      else
+      {
+         RemoveBlockFromGridData(CellIndex);
+      }
    }
 }
 
+ABlock* AGameModeInGame::RemoveBlockFromGridData(int32 CellIndex)
+{
+   ABlock* block = GetBlockActor(CellIndex);
+   mBlockActor[CellIndex] = nullptr;
+   mBoard.ClearCell(CellIndex);
+   return block;
+}
 
-int32 AGameModeInGame::GetLeftMatch(int32 Column, int32 Row, int32 BlockType) const
+void AGameModeInGame::DiscardBlock(int32 CellIndex)
 {
-   // Walk to the left
-   int32 current_column = Column - 1;
-   int32 data_index = GetCellIndex(current_column, Row);
-   if (data_index < 0)
-      return 0;
-
-   int32 counted = 0;
-   while (current_column >= 0)
+   // No need to bring instanced blocks back as actors just to discard them
+   if (mPlayField)
    {
-      ABlock* block = mGridData[data_index].BlockActor;
-
-      // If cell is empty or if the block is of different type, stop the counting
-      if (!block || !block->IsSameTypeID(BlockType))
-         return counted;
-
-      counted++;
-      data_index--;
-      current_column--;
+      mPlayField->ClearBlockInstance(CellIndex);
    }
-   return counted;
+   mBlockWork.AddRelease(mBlockActor[CellIndex]);
+   mBlockActor[CellIndex] = nullptr;
+   mBoard.ClearCell(CellIndex);
 }
 
-int32 AGameModeInGame::GetRightMatch(int32 Column, int32 Row, int32 BlockType) const
+ABlock* AGameModeInGame::GetBlockActor(int32 CellIndex)
 {
-   // Walk to the right
-   int32 current_column = Column + 1;
-   int32 data_index = GetCellIndex(current_column, Row);
-   if (data_index < 0)
-      return 0;
-
-   int32 counted = 0;
-   while (current_column < GetColumnCount())
+   ABlock* block = mBlockActor[CellIndex];
+   if (!block && mPlayField && mPlayField->HasBlockInstance(CellIndex))
    {
-      ABlock* block = mGridData[data_index].BlockActor;
-
-      // If cell is empty or if the block is of different type, stop the counting
-      if (!block || !block->IsSameTypeID(BlockType))
-         return counted;
-
-      counted++;
-      data_index++;
-      current_column++;
+      // The block is only drawn as an instance, but it's about to be animated so it needs its actor back
+      mPlayField->ClearBlockInstance(CellIndex);
+      block = SpawnBlock(mBoard.GetColumn(CellIndex), mBoard.GetRow(CellIndex), mBoard.GetType(CellIndex), false);
+      mBlockActor[CellIndex] = block;
    }
-   return counted;
+   return block;
 }
 
-int32 AGameModeInGame::GetUpMatch(int32 Column, int32 Row, int32 BlockType) const
+bool AGameModeInGame::CanInstanceBlock(const ABlock* Block) const
 {
-   // Walk upwards (add to the index)
-   int32 current_row = Row + 1;
-   int32 data_index = GetCellIndex(Column, current_row);
-   if (data_index < 0)
-      return 0;
-
-   int32 counted = 0;
-   while (current_row < GetRowCount())
-   {
-      ABlock* block = mGridData[data_index].BlockActor;
+   // Blueprint block classes (BP_Block for instance) only react to removal, which happens with an actor brought back
+   return mUseInstancedBlocks && mPlayField && Block->AllowsInstancing();
+}
 
-      // If cell is empty or if the block is of different type, stop the counting
-      if (!block || !block->IsSameTypeID(BlockType))
-         return counted;
+void AGameModeInGame::QueueShatterBursts(const TArray<int32>& Cells)
+{
+   // One burst per block type, placed at the center of the removed blocks of that type
+   const int32 type_count = mThemeTable.Num();
+   if (type_count == 0)
+      return;
 
-      counted++;
-      data_index += GetColumnCount();
-      current_row++;
+   TArray<FVector, TInlineAllocator<16>> location_sum;
+   TArray<int32, TInlineAllocator<16>> block_count;
+   location_sum.SetNumZeroed(type_count);
+   block_count.SetNumZeroed(type_count);
+
+   for (int32 cell_index : Cells)
+   {
+      const int32 type_id = mBoard.GetType(cell_index);
+      if (type_id >= 0 && type_id < type_count)
+      {
+         location_sum[type_id] += GetCellLocation(cell_index);
+         block_count[type_id]++;
+      }
    }
-   return counted;
-}
 
-int32 AGameModeInGame::GetDownMatch(int32 Column, int32 Row, int32 BlockType) const
-{
-   // Walk downwards (subtract from the index)
-   int32 current_row = Row - 1;
-   int32 data_index = GetCellIndex(Column, current_row);
-   if (data_index < 0)
-      return 0;
-
-   int32 counted = 0;
-   while (current_row >= 0)
+   // Bigger groups get bigger bursts, up to a limit
+   const float run_size = (float)FMath::Max(mBoard.GetMatchRules().RunSize, 1);
+   for (int32 type_id = 0; type_id < type_count; type_id++)
    {
-      ABlock* block = mGridData[data_index].BlockActor;
+      if (block_count[type_id] > 0)
+      {
+         const FVector location = location_sum[type_id] / (float)block_count[type_id] + FVector(0, 2, 0);
+         const float scale = FMath::Clamp(FMath::Sqrt(block_count[type_id] / run_size), 1.0f, mShatterMaxScale);
+         mShatterEffects.AddBurst(location, mThemeTable[type_id].ParticlesColor, scale);
+      }
+   }
+}
 
-      // If cell is empty or if the block is of different type, stop the counting
-      if (!block || !block->IsSameTypeID(BlockType))
-         return counted;
+UMaterialInstanceDynamic* AGameModeInGame::GetBlinkGroup(UMaterialInterface* Material)
+{
+   if (!Material)
+      return nullptr;
 
-      counted++;
-      data_index -= GetColumnCount();
-      current_row--;
+   // There is one group per distinct block material, which is very few
+   for (UMaterialInstanceDynamic* group : mBlinkGroup)
+   {
+      if (group->Parent == Material)
+         return group;
    }
-   return counted;
+
+   UMaterialInstanceDynamic* group = UMaterialInstanceDynamic::Create(Material, this);
+   group->SetScalarParameterValue(ABlock::IntensityParameter, 1.0f);
+   mBlinkGroup.Add(group);
+   return group;
 }
 
-int32 AGameModeInGame::GetUpLeftMatch(int32 Column, int32 Row, int32 BlockType) const
+void AGameModeInGame::InitBlockInstances()
 {
-   // Walk to the left and upwards
-   int32 current_column = Column - 1;
-   int32 current_row = Row + 1;
-   int32 data_index = GetCellIndex(current_column, current_row);
-   if (data_index < 0)
-      return 0;
-
-   int32 counted = 0;
-   while (current_row < GetRowCount() && current_column >= 0)
-   {
-      ABlock* block = mGridData[data_index].BlockActor;
+   if (!mUseInstancedBlocks || !mPlayField || !mThemeTable.Theme)
+      return;
 
-      // if cell is empty or if the block is of different type, stop the counting
-      if (!block || !block->IsSameTypeID(BlockType))
-         return counted;
+   const int32 type_count = mThemeTable.Num();
 
-      counted++;
-      data_index += GetColumnCount() - 1;
-      current_column--;
-      current_row++;
+   TArray<UMaterialInterface*> type_material;
+   TArray<FLinearColor> type_color;
+   type_material.Reserve(type_count);
+   type_color.Reserve(type_count);
+   for (int32 type_id = 0; type_id < type_count; type_id++)
+   {
+      type_material.Add(mThemeTable[type_id].Material);
+      type_color.Add(mThemeTable[type_id].SpriteColor);
    }
-   return counted;
+   mPlayField->InitBlockInstances(mThemeTable.BlockSprite, type_material, type_color);
 }
 
-int32 AGameModeInGame::GetUpRightMatch(int32 Column, int32 Row, int32 BlockType) const
-{
-   // Walk to the right and upwards
-   int32 current_column = Column + 1;
-   int32 current_row = Row + 1;
-   int32 data_index = GetCellIndex(current_column, current_row);
-   if (data_index < 0)
-      return 0;
-
-   int32 counted = 0;
-   while (current_row < GetRowCount() && current_column < GetColumnCount())
-   {
-      ABlock* block = mGridData[data_index].BlockActor;
 
-      // if cell is empty or if the block is of different type, stop the counting
-      if (!block || !block->IsSameTypeID(BlockType))
-         return counted;
+int32 AGameModeInGame::GetLeftMatch(int32 Column, int32 Row, int32 BlockType) const
+{
+   return mBoard.CountRun(Column, Row, -1, 0, BlockType);
+}
 
-      counted++;
-      data_index += GetColumnCount() + 1;
-      current_column++;
-      current_row++;
-   }
-   return counted;
+int32 AGameModeInGame::GetRightMatch(int32 Column, int32 Row, int32 BlockType) const
+{
+   return mBoard.CountRun(Column, Row, 1, 0, BlockType);
 }
 
-int32 AGameModeInGame::GetDownLeftMatch(int32 Column, int32 Row, int32 BlockType) const
+int32 AGameModeInGame::GetUpMatch(int32 Column, int32 Row, int32 BlockType) const
 {
-   // Walk to the left and downwards
-   int32 current_column = Column - 1;
-   int32 current_row = Row - 1;
-   int32 data_index = GetCellIndex(current_column, current_row);
-   if (data_index < 0)
-      return 0;
-
-   int32 counted = 0;
-   while (current_row >= 0 && current_column >= 0)
-   {
-      ABlock* block = mGridData[data_index].BlockActor;
+   return mBoard.CountRun(Column, Row, 0, 1, BlockType);
+}
 
-      // if cell is empty or if the block is of different type, stop the counting
-      if (!block || !block->IsSameTypeID(BlockType))
-         return counted;
+int32 AGameModeInGame::GetDownMatch(int32 Column, int32 Row, int32 BlockType) const
+{
+   return mBoard.CountRun(Column, Row, 0, -1, BlockType);
+}
 
-      counted++;
-      data_index -= (GetColumnCount() + 1);
-      current_column--;
-      current_row--;
-   }
-   return counted;
+int32 AGameModeInGame::GetUpLeftMatch(int32 Column, int32 Row, int32 BlockType) const
+{
+   return mBoard.CountRun(Column, Row, -1, 1, BlockType);
 }
 
-int32 AGameModeInGame::GetDownRightMatch(int32 Column, int32 Row, int32 BlockType) const
+int32 AGameModeInGame::GetUpRightMatch(int32 Column, int32 Row, int32 BlockType) const
 {
-   // Walk to the right and downwards
-   int32 current_column = Column + 1;
-   int32 current_row = Row - 1;
-   int32 data_index = GetCellIndex(current_column, current_row);
-   if (data_index < 0)
-      return 0;
-
-   int32 counted = 0;
-   while (current_row >= 0 && current_column < GetColumnCount())
-   {
-      ABlock* block = mGridData[data_index].BlockActor;
+   return mBoard.CountRun(Column, Row, 1, 1, BlockType);
+}
 
-      // if cell is empty or if the block is of different type, stop the counting
-      if (!block || !block->IsSameTypeID(BlockType))
-         return counted;
+int32 AGameModeInGame::GetDownLeftMatch(int32 Column, int32 Row, int32 BlockType) const
+{
+   return mBoard.CountRun(Column, Row, -1, -1, BlockType);
+}
 
-      counted++;
-      data_index += 1 - GetColumnCount();
-      current_column++;
-      current_row--;
-   }
-   return counted;
+int32 AGameModeInGame::GetDownRightMatch(int32 Column, int32 Row, int32 BlockType) const
+{
+   return mBoard.CountRun(Column, Row, 1, -1, BlockType);
 }
 
 
 bool AGameModeInGame::CheckMatchingBlocks()
 {
-   // First, cleanup the internal array
-   mMatchedBlock.Empty();
+   // First, cleanup the internal set
+   mMatchedBlock.Reset();
 
-   for (int32 cell_index : mLandedBlock)
-   {
-      // Obtain the block type
-      const int32 block_type = mGridData[cell_index].BlockActor->GetTypeID();
-      // And the column/row index for current cell
-      int32 column, row;
-      GetColumnRowFromCellIndex(cell_index, column, row);
-
-      // Count the blocks trying to find matching runs
-      CountHorizontalMatches(column, row, block_type);
-      CountVerticalMatches(column, row, block_type);
-      CountDiagonal1Matches(column, row, block_type);
-      CountDiagonal2Matches(column, row, block_type);
-   }
+   // A new run can only be formed if at least one block has been placed since the last check. Every run found
+   // before that has already been removed, so any run currently on the board goes through a landed block
+   if (mLandedBlock.Num() == 0)
+      return false;
+
+   // Depending on how many blocks landed, either probe around them or sweep the entire board
+   mBoard.FindMatchesAfterChange(mLandedBlock, mMatchedBlock);
 
-   // Remember, the counting functions will only add anything to the array if a matching run is found
    if (mMatchedBlock.Num() > 0)
    {
       // Empty the landed array since the data is not necessary anymore
@@ -539,31 +659,7 @@ bool AGameModeInGame::CheckMatchingBlocks()
 
 void AGameModeInGame::CheckGridFloorLevels()
 {
-   const int32 ref_index = (mGridRowCount - 1) * mGridColumnCount;
-
-   for (int32 col = 0; col < mGridColumnCount; col++)
-   {
-      // Assume the "floor" is above the grid
-      mColumnFloor[col] = -1;
-
-      int32 read_index = ref_index + col;
-      int32 read_row = mGridRowCount - 1;
-      while (read_index >= 0)
-      {
-         if (mGridData[read_index].BlockActor)
-         {
-            read_index = -1;    // this will stop the internal loop
-         }
-         else
-         {
-            // Reading cell is empty - assume this is the floor of this column
-            mColumnFloor[col] = read_row;
-
-            read_row--;
-            read_index -= mGridColumnCount;
-         }
-      }
-   }
+   mBoard.RefreshFloors();
 }
 
 
@@ -574,39 +670,49 @@ float AGameModeInGame::OnGetVerticalMoveTime_Implementation() const
 
 float AGameModeInGame::OnGetVerticalMoveTime_Internal() const
 {
-   return UColBPLibrary::GetVerticalMoveTime(this);
+   return mRules.VerticalMoveTime;
 }
 
 
 
 void AGameModeInGame::RestartGame()
 {
-   // Make sure there are no blocks in the grid
-   for (FGridCellData& cell_data : mGridData)
+   // Make sure there are no blocks in the grid. Releasing only hides the actors, so it's done right away, leaving
+   // them available to the next game
+   mBlockWork.CancelSpawns();
+   for (int32 cell_index = 0; cell_index < mBlockActor.Num(); cell_index++)
    {
-      if (cell_data.BlockActor)
-      {
-         cell_data.BlockActor->Destroy();
-         cell_data.BlockActor = nullptr;
-      }
+      mBlockPool.Release(mBlockActor[cell_index]);
+      mBlockActor[cell_index] = nullptr;
+   }
+   if (mPlayField)
+   {
+      mPlayField->ClearBlockInstances();
    }
 
-   // Reset all the floor levels
-   for (int32 i = 0; i < mColumnFloor.Num(); i++)
+   // Including the ones that were falling
+   for (int32 cell_index = 0; cell_index < mRepositioningBlock.Num(); cell_index++)
    {
-      mColumnFloor[i] = 0;
+      mBlockPool.Release(mRepositioningBlock[cell_index]);
+      mRepositioningBlock[cell_index] = nullptr;
    }
+   mTween.Reset();
+   mShatterEffects.Reset();
+
+   // This also resets all the floor levels
+   mBoard.Reset();
 
    // Make sure the helper arrays are empty
    mLandedBlock.Empty();
-   mMatchedBlock.Empty();
-   mRepositioningBlock.Empty();
+   mMatchedBlock.Reset();
+   mCascadeWave = 0;
 
    // And the next piece is "null"
    for (int32 i = 0; i < mNextBlock.Num(); i++)
    {
       mNextBlock[i] = -1;
    }
+   ReleaseNextPiece();
 
    // Finally, reset the state machine
    mCurrentState = &AGameModeInGame::StateGameInit;
@@ -616,78 +722,8 @@ void AGameModeInGame::RestartGame()
 
 FVector AGameModeInGame::GetCellLocation(int32 CellIndex) const
 {
-   return mPlayField->GetCellLocation(mGridData[CellIndex].TileMapColumn, mGridData[CellIndex].TileMapRow);
-}
-
-void AGameModeInGame::CountHorizontalMatches(int32 Column, int32 Row, int32 BlockType)
-{
-   const int32 left = GetLeftMatch(Column, Row, BlockType);
-   const int32 right = GetRightMatch(Column, Row, BlockType);
-   int32 read_index = GetCellIndex(Column, Row) - left;   // read "left" columns to the left from the central block
-
-   const int32 total_matches = left + right + 1;
-   if (total_matches >= UColBPLibrary::GetMinimumMatchRunSize(this))
-   {
-      // Setup the loop to fill the mMatchedBlock array
-      for (int32 i = 0; i < total_matches; i++)
-      {
-         mMatchedBlock.AddUnique(read_index);
-         read_index++;      // move to the right
-      }
-   }
-}
-
-void AGameModeInGame::CountVerticalMatches(int32 Column, int32 Row, int32 BlockType)
-{
-   const int32 up = GetUpMatch(Column, Row, BlockType);
-   const int32 down = GetDownMatch(Column, Row, BlockType);
-   int32 read_index = GetCellIndex(Column, Row) - (down * GetColumnCount());  // read "down" rows downwards from the central block
-
-   const int32 total_matches = up + down + 1;
-   if (total_matches >= UColBPLibrary::GetMinimumMatchRunSize(this))
-   {
-      for (int32 i = 0; i < total_matches; i++)
-      {
-         mMatchedBlock.AddUnique(read_index);
-         read_index += GetColumnCount();    // move one row up
-      }
-   }
-}
-
-void AGameModeInGame::CountDiagonal1Matches(int32 Column, int32 Row, int32 BlockType)
-{
-   const int32 up_left = GetUpLeftMatch(Column, Row, BlockType);
-   const int32 down_right = GetDownRightMatch(Column, Row, BlockType);
-   const int32 walk_delta = -GetColumnCount() + 1;     // shortcut to "walk" one row down and one column to the right
-   int32 read_index = GetCellIndex(Column, Row) - up_left + (up_left * GetColumnCount());   // read up_left columns to the left and up_left rows up
-
-   const int32 total_matches = up_left + down_right + 1;
-   if (total_matches >= UColBPLibrary::GetMinimumMatchRunSize(this))
-   {
-      for (int32 i = 0; i < total_matches; i++)
-      {
-         mMatchedBlock.AddUnique(read_index);
-         read_index += walk_delta;
-      }
-   }
-}
-
-void AGameModeInGame::CountDiagonal2Matches(int32 Column, int32 Row, int32 BlockType)
-{
-   const int32 down_left = GetDownLeftMatch(Column, Row, BlockType);
-   const int32 up_right = GetUpRightMatch(Column, Row, BlockType);
-   const int32 walk_delta = GetColumnCount() + 1;   // shortcut to "walk" one row up and one column to the right
-   int32 read_index = GetCellIndex(Column, Row) - down_left - (down_left * GetColumnCount());   // read down_left columns to the left and down_left rows down
-
-   const int32 total_matches = down_left + up_right + 1;
-   if (total_matches >= UColBPLibrary::GetMinimumMatchRunSize(this))
-   {
-      for (int32 i = 0; i < total_matches; i++)
-      {
-         mMatchedBlock.AddUnique(read_index);
-         read_index += walk_delta;
-      }
-   }
+   // The tile map indexes its rows from the top while the grid data goes bottom-up
+   return mPlayField->GetCellLocation(mBoard.GetColumn(CellIndex), mGridRowCount - 1 - mBoard.GetRow(CellIndex));
 }
 
 
@@ -718,14 +754,14 @@ void AGameModeInGame::OnSideMove(float AxisValue)
          return;
 
       // The row does not matter in this case since we only want the horizontal coordinate
-      const FVector dest_coord = GetCellLocation(dest_col, mColumnFloor[dest_col]);
+      const FVector dest_coord = GetCellLocation(dest_col, mBoard.GetFloor(dest_col));
 
       // Check horizontal collision
       if (mPlayerPiece.GetPieceZ() < dest_coord.Z)
          return;
 
       // Calculate the time limit fraction
-      const float htime_fraction = mPlayerPiece.GetHorizDiff(dest_coord.X) / mPlayField->GetScaledCellSize() * UColBPLibrary::GetHorizontalMoveTime(this);
+      const float htime_fraction = mPlayerPiece.GetHorizDiff(dest_coord.X) / mPlayField->GetScaledCellSize() * mRules.HorizontalMoveTime;
       const float vtime_fraction = mPlayerPiece.GetVertDiff(dest_coord.Z) / mPlayField->GetScaledCellSize() * OnGetVerticalMoveTime();
 
 
@@ -737,7 +773,7 @@ void AGameModeInGame::OnSideMove(float AxisValue)
       mPlayerPiece.SetCurrentColumn(dest_col);
 
       // Setup the input timing so we don't get uncontrollable movement
-      mSideMoveTimer = UColBPLibrary::GetSideMoveDelay(this);
+      mSideMoveTimer = mRules.SideMoveDelay;
    }
 }
 
@@ -756,7 +792,7 @@ void AGameModeInGame::OnRotatePiece(float AxisValue)
    {
       if (mShiftTimer <= 0.0f)
       {
-         mShiftTimer = UColBPLibrary::GetInputShiftDelay(this);
+         mShiftTimer = mRules.ShiftDelay;
 
          if (AxisValue < 0.0f)
          {
@@ -774,7 +810,7 @@ void AGameModeInGame::OnRotatePiece(float AxisValue)
 
 void AGameModeInGame::OnAccelerate()
 {
-   mPlayerPiece.SetVerticalAlphaMultiplier(UColBPLibrary::GetVerticalFastMultiplier(this));
+   mPlayerPiece.SetVerticalAlphaMultiplier(mRules.VerticalFastMultiplier);
 }
 
 void AGameModeInGame::OnDecelerate()
@@ -786,10 +822,31 @@ void AGameModeInGame::OnDecelerate()
 
 AGameModeInGame::StateFunctionProxy AGameModeInGame::StateGameInit(float Seconds)
 {
+   // Settings are read once per game, from here on the hot paths only read the copy
+   RefreshRuleSet();
+
+   // Match rules are read once per game, selecting the specialized matching code
+   const EMatchDirection match_directions = mRules.MatchDiagonal ? EMatchDirection::All : EMatchDirection::Orthogonal;
+   mBoard.SetMatchRules(FMatchRules(mRules.MatchRunSize, match_directions));
+   mBoard.SetLocalMatchCrossover(mLocalMatchBase, mLocalMatchDensity);
+
+   // The theme may have been selected after this game mode was constructed
+   CalculateWeightSum();
+   // Have enough block actors to fill the grid ready before the game starts. They are spawned within the block work
+   // budget, ahead of the initial blocks, and the countdown waits for them
+   PrewarmBlockPool();
+   // The theme may have changed, so the blink groups are rebuilt as needed
+   mBlinkGroup.Empty();
+   // The effect components are only created once, unless the settings change
+   mShatterEffects.Init(this, mShatterParticles, mShatterPoolSize);
+   InitBlockInstances();
+
    // Obtain the player piece size
-   const int32 piece_size = UColBPLibrary::GetPlayerPieceSize(this);
+   const int32 piece_size = mRules.PlayerPieceSize;
    // Initialize the player piece
    mPlayerPiece.InitArray(piece_size);
+   // A new block sequence for every game, unless a specific one was requested
+   mRandomStream.Initialize(mRandomSeed != 0 ? mRandomSeed : (int32)FPlatformTime::Cycles());
    // Initialize the "next piece" array:
    mNextBlock.SetNum(piece_size);
    for (int32 i = 0; i < piece_size; i++)
@@ -798,6 +855,8 @@ AGameModeInGame::StateFunctionProxy AGameModeInGame::StateGameInit(float Seconds
    }
    // Fire up the piece changed event
    mOnNextPieceChanged.Broadcast(mNextBlock);
+   // Have the first piece ready before spawning it
+   PrepareNextPiece();
    // Reset the player controller data
    if (AColPlayerController* pc = UColBPLibrary::GetColPlayerController(this))
    {
@@ -812,6 +871,9 @@ AGameModeInGame::StateFunctionProxy AGameModeInGame::StateGameInit(float Seconds
    // Broadcast start countdown event
    mOnStartCountdown.Broadcast(mInitialCountdown);
 
+   // Whatever the previous game left behind is collected during the countdown
+   mGarbageScheduler.RequestCollection();
+
    // Transition into the StartCountdown state
    return &AGameModeInGame::StateStartCountdown;
 }
@@ -828,7 +890,8 @@ AGameModeInGame::StateFunctionProxy AGameModeInGame::StateStartCountdown(float S
    const bool completed = (display_value == 0);
    mOnUpdateStartCountdown.Broadcast(display_value, completed);
 
-   if (completed)
+   // The initial blocks may still be spawning when the countdown ends on very large grids
+   if (completed && mBlockWork.IsIdle())
       return &AGameModeInGame::StateSpawning;
 
    return &AGameModeInGame::StateStartCountdown;
@@ -851,7 +914,7 @@ AGameModeInGame::StateFunctionProxy AGameModeInGame::StateSpawning(float Seconds
    {
       // Game not lost. Spawn a new player piece
       // Spawn piece at:
-      const int32 spawn_row = GetRowCount() - UColBPLibrary::GetPlayerPieceSize(this);
+      const int32 spawn_row = GetRowCount() - mRules.PlayerPieceSize;
       const int32 spawn_col = GetColumnCount() / 2;
 
       mPlayerPiece.SpawnPiece([this, &spawn_row, &spawn_col](int32 Index)
@@ -860,6 +923,22 @@ AGameModeInGame::StateFunctionProxy AGameModeInGame::StateSpawning(float Seconds
          const int32 spawn_type_id = mNextBlock[Index];
          // Substitute the next block type id with a new random one
          mNextBlock[Index] = PickRandomBlock();
+
+         // The block has normally been prepared ahead of time, so it only has to be revealed
+         ABlock* block = mNextPieceBlock.IsValidIndex(Index) ? mNextPieceBlock[Index] : nullptr;
+         if (block)
+         {
+            mNextPieceBlock[Index] = nullptr;
+            if (block->GetTypeID() == spawn_type_id)
+            {
+               block->SetBlockLocation(GetCellLocation(spawn_col, spawn_row + Index) + FVector(0, 1, 0));
+               block->SetPoolActive(true);
+               return block;
+            }
+            // The next piece has been changed after the block was prepared
+            mBlockPool.Release(block);
+         }
+
          // Spawn the block
          return SpawnBlock(spawn_col, spawn_row + Index, spawn_type_id, false);
       });
@@ -871,7 +950,7 @@ AGameModeInGame::StateFunctionProxy AGameModeInGame::StateSpawning(float Seconds
       mPlayerPiece.SetCurrentColumn(spawn_col);
 
       // Setup the vertical movement
-      const float vert_dest = GetCellLocation(spawn_col, mColumnFloor[spawn_col]).Z;
+      const float vert_dest = GetCellLocation(spawn_col, mBoard.GetFloor(spawn_col)).Z;
       const float vert_time = mPlayerPiece.GetVertDiff(vert_dest) / mPlayField->GetScaledCellSize() * OnGetVerticalMoveTime();
 
       mPlayerPiece.VerticalMove(vert_dest, vert_time);
@@ -890,11 +969,17 @@ AGameModeInGame::StateFunctionProxy AGameModeInGame::StateSpawning(float Seconds
 
 AGameModeInGame::StateFunctionProxy AGameModeInGame::StatePlaytime(float Seconds)
 {
+   // Get the blocks of the next piece ready while the player is busy with this one, off the spawn frame
+   PrepareNextPiece();
+
    // Update the blocks within the player piece
-   mPlayerPiece.Tick(Seconds);
+   mPlayerPiece.Tick(Seconds, mMoveBatch);
 
    if (mPlayerPiece.HasLanded())
    {
+      // The blocks must be at their final location before being handed to the grid
+      mMoveBatch.Apply();
+
       // Obtain the column where the piece has landed
       const int32 column = mPlayerPiece.GetCurrentColumn();
 
@@ -904,33 +989,36 @@ AGameModeInGame::StateFunctionProxy AGameModeInGame::StatePlaytime(float Seconds
       mPlayerPiece.ForEachBlock([this, &column](ABlock* block)
       {
          // Get the cell index where the block is being added
-         const int32 cell_index = GetCellIndex(column, mColumnFloor[column]);
+         const int32 cell_index = GetCellIndex(column, mBoard.GetFloor(column));
 
          // Add the index into the landed array
          mLandedBlock.Add(cell_index);
 
-         // Add the block into the grid data
+         // Add the block into the grid data, which also raises the floor level
          AddBlockToGridData(cell_index, block);
-
-         // And update the floor level
-         mColumnFloor[column]++;
       });
 
       // Cleanup the player piece's internal data
       mPlayerPiece.Clear();
 
       // Play the sound effect associated with the player piece landing
-      if (UThemeData* theme = UColBPLibrary::GetGameTheme(this))
+      if (mThemeTable.LandingSound)
       {
-         if (theme->LandingBlockSound)
-         {
-            UGameplayStatics::PlaySound2D(GetWorld(), theme->LandingBlockSound);
-         }
+         UGameplayStatics::PlaySound2D(GetWorld(), mThemeTable.LandingSound);
       }
 
       // Fire up the event
       OnPlayerPieceLanded(mLandedBlock);
 
+      // With the grid updated the whole cascade can be resolved. From here on the states only play it back
+      FCascadeRules rules;
+      rules.ScorePerBlock = mScorePerBlock;
+      rules.InitialMultiplier = mCurrentBonusMultiplier;
+      rules.MultiplierDelta = mChainedMultiDelta;
+
+      mCascade.Resolve(mBoard, mLandedBlock, rules);
+      mCascadeWave = 0;
+
       // Transition into the `Check Match` state
       return &AGameModeInGame::StateCheckMatch;
    }
@@ -940,18 +1028,39 @@ AGameModeInGame::StateFunctionProxy AGameModeInGame::StatePlaytime(float Seconds
 
 AGameModeInGame::StateFunctionProxy AGameModeInGame::StateCheckMatch(float Seconds)
 {
-   if (CheckMatchingBlocks())
+   // The matches have already been found when the piece landed, so just check if there is a wave left to be played
+   if (mCascadeWave < mCascade.GetWaves().Num())
    {
+      const FCascadeWave& wave = mCascade.GetWaves()[mCascadeWave];
+
+      // The landed blocks have been taken into account by the resolver
+      mLandedBlock.Empty();
       // Setup the blinking timer
-      mBlinkTime.Set(UColBPLibrary::GetBlinkingTime(this));
-      // Calculate the player score delta
-      const int32 score_delta = mMatchedBlock.Num() * mScorePerBlock * mCurrentBonusMultiplier;
-      // Add to the player score
-      UColBPLibrary::ChangeScore(this, score_delta);
+      const float blink_time = mRules.BlinkingTime;
+      mBlinkTime.Set(blink_time);
+      // A long enough blink hides the collection of the garbage left by the previous waves
+      if (blink_time >= mGarbageBlinkWindow)
+      {
+         mGarbageScheduler.RequestCollection();
+      }
+      // Matched blocks join the blink group of their material once, rather than each one being updated every frame
+      for (UMaterialInstanceDynamic* group : mBlinkGroup)
+      {
+         group->SetScalarParameterValue(ABlock::IntensityParameter, 1.0f);
+      }
+      for (int32 cell_index : wave.MatchedCells)
+      {
+         if (ABlock* block = GetBlockActor(cell_index))
+         {
+            block->SetBlinkGroup(GetBlinkGroup(block->GetSharedMaterial()));
+         }
+      }
+      // Add the wave score to the player score
+      UColBPLibrary::ChangeScore(this, wave.Score);
       // Increase the bonus multiplier
       mCurrentBonusMultiplier += mChainedMultiDelta;
-      // Fire up the event
-      OnBlockMatched(mMatchedBlock);
+      // Fire up the event, with the cells in ascending order
+      OnBlockMatched(wave.MatchedCells);
       // And transition into the removing block state.
       return &AGameModeInGame::StateRemovingBlock;
    }
@@ -963,28 +1072,41 @@ AGameModeInGame::StateFunctionProxy AGameModeInGame::StateRemovingBlock(float Se
    const float alpha = mBlinkTime.Update(Seconds);
    if (alpha >= 1.0f)
    {
-      if (UThemeData* theme = UColBPLibrary::GetGameTheme(this))
+      if (mThemeTable.RemovingSound)
       {
-         if (theme->RemovingBlockSound)
+         UGameplayStatics::PlaySound2D(GetWorld(), mThemeTable.RemovingSound);
+      }
+
+      const TArray<int32>& matched_cells = mCascade.GetWaves()[mCascadeWave].MatchedCells;
+      if (mShatterEffects.IsEnabled())
+      {
+         // The native effects replace the per block event, merging the whole wave into a few bursts
+         QueueShatterBursts(matched_cells);
+         for (int32 cell_index : matched_cells)
          {
-            UGameplayStatics::PlaySound2D(GetWorld(), theme->RemovingBlockSound);
+            mBlockPool.Release(RemoveBlockFromGridData(cell_index));
          }
       }
-
-      for (int32 cell_index : mMatchedBlock)
+      else
       {
-         mGridData[cell_index].BlockActor->OnBeingDestroyed();
-         mGridData[cell_index].BlockActor->Destroy();
-         mGridData[cell_index].BlockActor = nullptr;
+         for (int32 cell_index : matched_cells)
+         {
+            // The actor may still be waiting in the block work queue. Clearing the cell drops its spawn
+            if (ABlock* block = RemoveBlockFromGridData(cell_index))
+            {
+               block->OnBeingDestroyed();
+               mBlockPool.Release(block);
+            }
+         }
       }
-      mMatchedBlock.Empty();
    }
    else
    {
-      const float intensity = (FMath::Cos(alpha * UColBPLibrary::GetBlinkingSpeed(this)) + 1.0f) / 2.0f;
-      for (int32 cell_index : mMatchedBlock)
+      // One parameter per blink group, no matter how many blocks are blinking
+      const float intensity = (FMath::Cos(alpha * mRules.BlinkingSpeed) + 1.0f) / 2.0f;
+      for (UMaterialInstanceDynamic* group : mBlinkGroup)
       {
-         mGridData[cell_index].BlockActor->SetIntensity(intensity);
+         group->SetScalarParameterValue(ABlock::IntensityParameter, intensity);
       }
 
       return &AGameModeInGame::StateRemovingBlock;
@@ -995,114 +1117,89 @@ AGameModeInGame::StateFunctionProxy AGameModeInGame::StateRemovingBlock(float Se
 
 AGameModeInGame::StateFunctionProxy AGameModeInGame::StateCheckPlayfield(float Seconds)
 {
-   // Make sure we have an empty array otherwise we risk some unpleasant bugs
-   mRepositioningBlock.Empty();
-
-   const int32 column_count = GetColumnCount();
-   for (int32 col = 0; col < column_count; col++)
+   // The resolver already knows which blocks fall and where to. Setup their movement
+   const FCascadeWave& wave = mCascade.GetWaves()[mCascadeWave];
+   // Destination cell and type of the falling blocks whose actor has not been spawned yet
+   TArray<TPair<int32, int32>, TInlineAllocator<16>> unspawned;
+   for (const FCascadeMove& move : wave.Moves)
    {
-      int32 new_floor = 0;
-      int32 read_index = GetCellIndex(col, 0);
+      // The actor may still be waiting in the block work queue, in which case its type is needed to queue it again
+      const int32 type_id = mBoard.GetType(move.FromCell);
 
-      for (int32 row = 0; row < mColumnFloor[col]; row++)
+      // Take the actor out of the grid, it will be added back once the repositioning is finished
+      ABlock* block = RemoveBlockFromGridData(move.FromCell);
+      if (!block)
       {
-         // Obtain the pointer to the actor and make sure it's valid
-         ABlock* block = mGridData[read_index].BlockActor;
-
-         if (block)
-         {
-            const int32 gap_level = row - new_floor;
-
-            if (gap_level > 0)
-            {
-               // Cell is not empty - the block in there must be moved down since there is a gap
-               // Because we already have the pointer, clear the data from the grid
-               mGridData[read_index].BlockActor = nullptr;
-
-               // Total time limit is easy since it's the time for a single cell, while gap_level holds the amount of cells that must be moved down
-               const float total_time = (float)gap_level * UColBPLibrary::GetRepositionMoveTime(this);
-
-               // Update the repositioning array
-               mRepositioningBlock.Add(FRepositioningBlock(total_time, GetCellIndex(col, new_floor), block));
-
-               // Obtain the destination Z coordinate in order to setup vertical movement
-               const float dest_z = GetCellLocation(col, new_floor).Z;
-
-               // Setup the original position
-               block->InitOriginalPosition();
+         unspawned.Add(TPair<int32, int32>(move.ToCell, type_id));
+         continue;
+      }
+      mRepositioningBlock[move.ToCell] = block;
 
-               // Setup the vertical movement
-               block->SetupVertical(dest_z);
-            }
+      // Total time limit is easy since it's the time for a single cell, while the distance holds the amount of cells that must be moved down
+      const float total_time = (float)move.Distance * mRules.RepositionMoveTime;
 
-            new_floor++;
-         }
+      // Only the Z coordinate changes, towards the destination cell. The tween is identified by that cell
+      const FVector start = block->GetActorLocation();
+      const FVector end(start.X, start.Y, GetCellLocation(move.ToCell).Z);
+      mTween.Add(move.ToCell, start, end, total_time);
+   }
 
-         // Move the reading index into the row above
-         read_index += GetColumnCount();
-      }
+   // Removing the cell dropped the pending spawn, so queue it again at the destination. Done once every falling block has
+   // left its cell since a destination may be the origin of another move. There is nothing to animate for these
+   for (const TPair<int32, int32>& it : unspawned)
+   {
+      QueueBlock(it.Key % mGridColumnCount, it.Key / mGridColumnCount, it.Value);
+   }
 
-      // Update the floor level
-      mColumnFloor[col] = new_floor;
+   // Update the floor levels of the columns that lost blocks
+   for (const FCascadeFloor& floor : wave.Floors)
+   {
+      mBoard.SetFloor(floor.Column, floor.Floor);
    }
 
-   return (mRepositioningBlock.Num() > 0 ? &AGameModeInGame::StateRepositioning : &AGameModeInGame::StateSpawning);
+   // This wave is done. If there is another one it will be picked by the match checking state
+   mCascadeWave++;
+
+   // The falling blocks array always spans the whole grid, so the tweens tell if anything has to fall
+   return (mTween.HasPending() ? &AGameModeInGame::StateRepositioning : &AGameModeInGame::StateSpawning);
 }
 
 AGameModeInGame::StateFunctionProxy AGameModeInGame::StateRepositioning(float Seconds)
 {
-   bool finished = true;      // Assume all blocks have finished the repositioning
-   bool play_sound = false;   // Assume no block has finished relocation
+   // Advance every falling block in a single pass
+   mTween.Update(Seconds);
 
-   for (FRepositioningBlock& rep_block : mRepositioningBlock)
+   const TArrayView<const int32> targets = mTween.GetTargets();
+   const TArrayView<const FVector> values = mTween.GetValues();
+   for (int32 i = 0; i < targets.Num(); i++)
    {
-      if (!rep_block.RepositionFinished)
-      {
-         // Update the timing
-         const float alpha = rep_block.Timing.Update(Seconds);
-
-         // We need some coordinates otherwise the actor will warp around when calling "SetActorLocation()"
-         FVector interp_pos = rep_block.BlockActor->GetActorLocation();
-
-         // And interpolate the Z coordinate
-         rep_block.RepositionFinished = rep_block.BlockActor->InterpolateVertical(alpha, interp_pos.Z);
-
-         // Update the location
-         rep_block.BlockActor->SetActorLocation(interp_pos);
-
-         // And the internal flag - after the Update() RepositionFinished variable may be different
-         finished = finished & rep_block.RepositionFinished;
-
-         if (rep_block.RepositionFinished)
-         {
-            // Previously this block was still repositioning, now it finished. Prepare things for the match check algorithm
-            mLandedBlock.Add(rep_block.CellIndex);
+      mMoveBatch.Add(mRepositioningBlock[targets[i]], values[i]);
+   }
 
-            // Make sure the grid data is holding this block
-            AddBlockToGridData(rep_block.CellIndex, rep_block.BlockActor);
+   // Blocks that have just reached their destination go back into the grid
+   const bool play_sound = mTween.GetCompleted().Num() > 0;
+   for (int32 cell_index : mTween.GetCompleted())
+   {
+      // Prepare things for the match check algorithm
+      mLandedBlock.Add(cell_index);
 
-            // We have to play the sound effect
-            play_sound = true;
-         }
-      }
+      // Make sure the grid data is holding this block
+      AddBlockToGridData(cell_index, mRepositioningBlock[cell_index]);
+      mRepositioningBlock[cell_index] = nullptr;
    }
+   const bool finished = !mTween.HasPending();
 
    if (play_sound)
    {
-      if (UThemeData* theme = UColBPLibrary::GetGameTheme(this))
+      if (mThemeTable.LandingSound)
       {
-         if (theme->LandingBlockSound)
-         {
-            UGameplayStatics::PlaySound2D(GetWorld(), theme->LandingBlockSound);
-         }
+         UGameplayStatics::PlaySound2D(GetWorld(), mThemeTable.LandingSound);
       }
    }
 
    if (finished)
    {
-      // Cleanup the repositioning array and transition into the match checking state
-      mRepositioningBlock.Empty();
-
+      // Transition into the match checking state
       return &AGameModeInGame::StateCheckMatch;
    }
 
@@ -1114,16 +1211,12 @@ AGameModeInGame::StateFunctionProxy AGameModeInGame::StateGameLost(float Seconds
 
    mCurrentClearTime += Seconds;
 
-   if (mCurrentClearTime >= mGameOverClearTime)
+   if (mCurrentClearRow >= 0 && mCurrentClearTime >= mGameOverClearTime)
    {
       int32 clear_index = GetCellIndex(0, mCurrentClearRow);
       for (int32 col = 0; col < mGridColumnCount; col++)
       {
-         if (mGridData[clear_index].BlockActor)
-         {
-            mGridData[clear_index].BlockActor->Destroy();
-            mGridData[clear_index].BlockActor = nullptr;
-         }
+         DiscardBlock(clear_index);
          clear_index++;   // move to next column
       }
 
@@ -1133,12 +1226,14 @@ AGameModeInGame::StateFunctionProxy AGameModeInGame::StateGameLost(float Seconds
 
       // Move to the next row
       mCurrentClearRow--;
+   }
 
-      if (mCurrentClearRow < 0)
-      {
-         mOnPostGameOver.Broadcast();
-         return &AGameModeInGame::StateEndGame;
-      }
+   // Only finish once every discarded block actor has been released
+   if (mCurrentClearRow < 0 && mBlockWork.IsIdle())
+   {
+      mGarbageScheduler.RequestCollection();
+      mOnPostGameOver.Broadcast();
+      return &AGameModeInGame::StateEndGame;
    }
 
    return &AGameModeInGame::StateGameLost;
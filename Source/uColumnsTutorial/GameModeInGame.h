@@ -11,6 +11,15 @@
 #include "uColumnsTutorialGameModeBase.h"
 #include "helpers.h"
 #include "PlayerPiece.h"
+#include "ColumnsBoard.h"
+#include "CascadeResolver.h"
+#include "BlockPicker.h"
+#include "TweenScheduler.h"
+#include "BlockPool.h"
+#include "ShatterEffects.h"
+#include "BlockWorkQueue.h"
+#include "GarbageScheduler.h"
+#include "ThemeData.h"
 #include "GameModeInGame.generated.h"
 
 DECLARE_DYNAMIC_DELEGATE_OneParam(FOnNextPieceChangedDelegate, const TArray<int32>&, NextPiece);
@@ -49,18 +58,48 @@ public:
    
    virtual void BeginPlay() override;
 
+   virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
    virtual void Tick(float DeltaTime) override;
 
 
+   // Take the compiled table of the current theme and setup the block type weights from it
    UFUNCTION(BlueprintCallable)
    void CalculateWeightSum();
 
+   // Select a block type from the theme weights, using the random stream of the current game
    UFUNCTION(BlueprintPure)
    int32 PickRandomBlock() const;
 
+   // Seed of the random stream of the current game. Setting it as the Random Seed property replays the same block sequence
+   UFUNCTION(BlueprintPure)
+   int32 GetGameSeed() const { return mRandomStream.GetInitialSeed(); }
+
    UFUNCTION(BlueprintCallable)
    class ABlock* SpawnBlock(int32 Column, int32 Row, int32 TypeID, bool AddToGrid);
 
+   // Place a block into the grid data right away, with its actor spawned in a later frame within the block work budget
+   UFUNCTION(BlueprintCallable)
+   void QueueBlock(int32 Column, int32 Row, int32 TypeID);
+
+   // Tell if there are block actors still waiting to be spawned or released
+   UFUNCTION(BlueprintPure)
+   bool IsBlockWorkPending() const { return !mBlockWork.IsIdle(); }
+
+   // Mark the captured gameplay settings as stale so they are read again from the game instance when the next game begins.
+   // A game in progress keeps the settings it started with. Done automatically whenever the settings are changed through
+   // the game instance
+   UFUNCTION(BlueprintCallable)
+   void InvalidateRuleSet();
+
+   // Garbage collections since the game mode began play
+   UFUNCTION(BlueprintPure)
+   int32 GetGarbageCollectionCount() const { return mGarbageScheduler.GetCollectionCount(); }
+
+   // Garbage collections that were not requested and happened while a piece was in play or blocks were being matched or falling
+   UFUNCTION(BlueprintPure)
+   int32 GetActivePlayGarbageCollectionCount() const { return mGarbageScheduler.GetActivePlayCollectionCount(); }
+
 
 
    UFUNCTION(BlueprintPure)
@@ -121,6 +160,14 @@ public:
    UFUNCTION(BlueprintCallable)
    bool CheckMatchingBlocks();
 
+   // Amount of match waves triggered by the last landed piece. This is known as soon as the piece lands
+   UFUNCTION(BlueprintPure)
+   int32 GetCascadeWaveCount() const { return mCascade.GetWaves().Num(); }
+
+   // Total score the last landed piece gives once all of its match waves are played
+   UFUNCTION(BlueprintPure)
+   int32 GetCascadeScore() const { return mCascade.GetTotalScore(); }
+
 
 
    // Native C++ code for custom GameInit state code
@@ -140,8 +187,10 @@ public:
 
 
    UFUNCTION(BlueprintPure)
-   int32 GetFloor(int32 Column) const { return mColumnFloor[Column]; }
+   int32 GetFloor(int32 Column) const { return mBoard.GetFloor(Column); }
 
+   // Rescan every column to find the floor levels. Floors are kept up to date as blocks are added, removed and
+   // repositioned, so this is only necessary if the grid is changed through other means
    UFUNCTION(BlueprintCallable)
    void CheckGridFloorLevels();
 
@@ -207,13 +256,55 @@ public:
    UFUNCTION(BlueprintCallable)
    void RestartGame();
 
+protected:
+   // The gameplay data of the grid, without any actor
+   const FColumnsBoard& GetBoard() const { return mBoard; }
+
+   // The gameplay settings captured from the game instance
+   const FColRuleSet& GetRuleSet() const { return mRules; }
+
 private:
    FVector GetCellLocation(int32 CellIndex) const;
 
-   void CountHorizontalMatches(int32 Column, int32 Row, int32 BlockType);
-   void CountVerticalMatches(int32 Column, int32 Row, int32 BlockType);
-   void CountDiagonal1Matches(int32 Column, int32 Row, int32 BlockType);
-   void CountDiagonal2Matches(int32 Column, int32 Row, int32 BlockType);
+   // Remove the block from the grid data, returning its actor (if any)
+   class ABlock* RemoveBlockFromGridData(int32 CellIndex);
+
+   // Remove the block from the grid data, sending its actor (if any) back into the pool
+   void DiscardBlock(int32 CellIndex);
+
+   // Obtain the actor of the cell. Blocks that are only drawn as instances get an actor back
+   class ABlock* GetBlockActor(int32 CellIndex);
+
+   // Tell if the block can be drawn as an instance while resting in the grid
+   bool CanInstanceBlock(const class ABlock* Block) const;
+
+   // Setup the instanced block rendering of the play field, if enabled, with the current theme
+   void InitBlockInstances();
+
+   // Queue the shatter effects of the removed cells, merged into one burst per block type
+   void QueueShatterBursts(const TArray<int32>& Cells);
+
+   // Obtain the dynamic material shared by all blinking blocks using the specified material, creating it if necessary
+   class UMaterialInstanceDynamic* GetBlinkGroup(class UMaterialInterface* Material);
+
+   // Spawn the hidden blocks of the next piece, for any that is not ready yet
+   void PrepareNextPiece();
+
+   // Send the prepared next piece blocks back into the pool
+   void ReleaseNextPiece();
+
+   // Spawn or release queued block actors, within the block work budget
+   void ProcessBlockWork();
+
+   // Tell if the current state is part of active play, where garbage collection should not happen
+   bool IsActivePlayState() const;
+
+   // Capture the gameplay settings from the game instance if they have been invalidated
+   void RefreshRuleSet();
+
+   // Queue the spawning of the block actors necessary to fill the grid into the pool, split among the block classes of the theme.
+   // Blocks already in the pool or waiting to be released into it are taken into account
+   void PrewarmBlockPool();
 
 
    // Input event handlers
@@ -257,6 +348,51 @@ private:
    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Gameplay Settings", meta = (DisplayName = "Chained Multiplier Delta", AllowPrivateAccess = true))
    float mChainedMultiDelta;
 
+   // Up to this many landed blocks (plus the density below) are probed individually when looking for matches, rather than sweeping the entire grid
+   UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Performance", meta = (DisplayName = "Local Match Base", AllowPrivateAccess = true))
+   int32 mLocalMatchBase;
+
+   // Fraction of the grid cells that can be probed individually when looking for matches, on top of the base amount
+   UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Performance", meta = (DisplayName = "Local Match Density", AllowPrivateAccess = true))
+   float mLocalMatchDensity;
+
+   // Draw blocks resting in the grid as instances of the play field rather than as individual actors. Only blocks whose class allows instancing are affected
+   UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Performance", meta = (DisplayName = "Instanced Block Rendering", AllowPrivateAccess = true))
+   bool mUseInstancedBlocks;
+
+   // Milliseconds per frame that can be spent spawning or releasing block actors when the grid is filled or cleared in bulk
+   UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Performance", meta = (DisplayName = "Block Work Budget", ClampMin = 0, AllowPrivateAccess = true))
+   float mBlockWorkBudget;
+
+   // Hold garbage collection back during active play, collecting at the countdown, the end of the game and long blinks instead
+   UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Performance", meta = (DisplayName = "Defer Garbage Collection", AllowPrivateAccess = true))
+   bool mDeferGarbageCollection;
+
+   // Once the process uses more than this many megabytes garbage collection is no longer held back. Zero means no ceiling
+   UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Performance", meta = (DisplayName = "Garbage Memory Ceiling", ClampMin = 0, AllowPrivateAccess = true))
+   float mGarbageMemoryCeiling;
+
+   // Matched blocks blinking for at least this many seconds give enough of a pause to collect garbage
+   UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Performance", meta = (DisplayName = "Garbage Blink Window", ClampMin = 0, AllowPrivateAccess = true))
+   float mGarbageBlinkWindow;
+
+   // If set, removed blocks are shattered by this particle system (PS_Shatter for instance) from a fixed pool of components, with each match wave
+   // merged into one burst per block type. Blocks don't fire OnBeingDestroyed when matched in this case
+   UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Effects", meta = (DisplayName = "Shatter Particles", AllowPrivateAccess = true))
+   class UParticleSystem* mShatterParticles;
+
+   // How many shatter particle systems can be alive at once
+   UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Effects", meta = (DisplayName = "Shatter Pool Size", ClampMin = 1, AllowPrivateAccess = true))
+   int32 mShatterPoolSize;
+
+   // How many shatter bursts can be started in a single frame. The others wait for the following frames
+   UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Effects", meta = (DisplayName = "Shatter Bursts Per Frame", ClampMin = 1, AllowPrivateAccess = true))
+   int32 mShatterBurstsPerFrame;
+
+   // Largest scale of a merged burst
+   UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Effects", meta = (DisplayName = "Shatter Max Scale", ClampMin = 1, AllowPrivateAccess = true))
+   float mShatterMaxScale;
+
    // Specify a custom widget element that will be placed in the top are of the HUD
    UPROPERTY(EditAnywhere, Category = "User Interface", meta = (DisplayName = "CustomHUDTop"))
    TSubclassOf<UUserWidget> mCustomHUDTop;
@@ -276,6 +412,12 @@ private:
    UPROPERTY()
    float mWeightSum;
 
+   FBlockPicker mBlockPicker;
+
+   // Copy of the compiled theme, taken along with the weights
+   UPROPERTY()
+   FThemeTable mThemeTable;
+
    UPROPERTY()
    FOnNextPieceChangedMultiDelegate mOnNextPieceChanged;
 
@@ -297,18 +439,53 @@ private:
    class APlayField* mPlayField;
 
 
-   TArray<FGridCellData> mGridData;
-   TArray<int32> mColumnFloor;
+   // Block types and floor levels of the grid
+   FColumnsBoard mBoard;
+   // The actor of each grid cell. Null in cells drawn as instances
+   UPROPERTY()
+   TArray<class ABlock*> mBlockActor;
+   // Removed block actors are kept here to be reused
+   UPROPERTY()
+   FBlockPool mBlockPool;
    TArray<int32> mLandedBlock;
-   TArray<int32> mMatchedBlock;
-   TArray<FRepositioningBlock> mRepositioningBlock;
+   FMatchedCellSet mMatchedBlock;
+   // The actor falling into each grid cell, while its tween is running
+   UPROPERTY()
+   TArray<class ABlock*> mRepositioningBlock;
+   // Movement of the falling blocks, identified by destination cell
+   FTweenScheduler mTween;
    TArray<int32> mNextBlock;
+   // Hidden, already initialized blocks matching mNextBlock, revealed when the piece is spawned
+   UPROPERTY()
+   TArray<class ABlock*> mNextPieceBlock;
+
+   // Computes the entire chain of matches once a piece lands. The states then only play back its waves
+   FCascadeResolver mCascade;
+   // The wave currently being played back
+   int32 mCascadeWave;
 
 
    FTiming mBlinkTime;
 
+   UPROPERTY()
+   FShatterEffects mShatterEffects;
+   // Block actors waiting to be spawned or released, spread over several frames
+   UPROPERTY()
+   FBlockWorkQueue mBlockWork;
+   FGarbageScheduler mGarbageScheduler;
+
+   FColRuleSet mRules;
+   bool mRulesDirty;
+   FDelegateHandle mRulesChangedHandle;
+   // Dynamic materials driving the blink of matched blocks, one per distinct block material
+   UPROPERTY()
+   TArray<class UMaterialInstanceDynamic*> mBlinkGroup;
+
    FPlayerPiece mPlayerPiece;
 
+   // Locations of the blocks moved during the current frame
+   FBlockMoveBatch mMoveBatch;
+
    float mShiftTimer;
    float mSideMoveTimer;
 
@@ -318,6 +495,13 @@ private:
 
    float mCurrentCountdown;
 
+   // Seed of the block sequence. Zero picks a new seed for every game
+   UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Gameplay Settings", meta = (DisplayName = "Random Seed", AllowPrivateAccess = true))
+   int32 mRandomSeed;
+
+   // Every block type selection of a game is drawn from this stream, seeded when the game begins
+   FRandomStream mRandomStream;
+
    // Specify the audio asset that will be played when the game is over
    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Gameplay Settings", meta = (DisplayName = "Game Over Audio", AllowPrivateAccess = true))
    USoundWave* mGameOverAudio;
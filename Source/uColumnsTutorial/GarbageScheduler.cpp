@@ -0,0 +1,77 @@
+/**
+ * This source code is provided as reference/companion material for the uColumnsTutorial
+ * that can be freely found at http://www.kehomsforge.com and should not be commercialized
+ * in any form. It should remain free!
+ *
+ * By Yuri Sarudiansky
+ */
+
+#include "GarbageScheduler.h"
+#include "Engine/Engine.h"
+#include "HAL/PlatformMemory.h"
+#include "UObject/UObjectGlobals.h"
+
+
+void FGarbageScheduler::Init(bool Enabled, float CeilingMB)
+{
+   Shutdown();
+
+   mEnabled = Enabled;
+   mMemoryCeiling = (uint64)(FMath::Max(CeilingMB, 0.0f) * 1024.0f * 1024.0f);
+   mActivePlay = false;
+   mCollectRequested = false;
+   mCollectionCount = 0;
+   mActivePlayCollectionCount = 0;
+
+   mPostCollectHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddRaw(this, &FGarbageScheduler::OnPostGarbageCollect);
+}
+
+void FGarbageScheduler::Shutdown()
+{
+   if (mPostCollectHandle.IsValid())
+   {
+      FCoreUObjectDelegates::GetPostGarbageCollect().Remove(mPostCollectHandle);
+      mPostCollectHandle.Reset();
+   }
+}
+
+void FGarbageScheduler::Tick(bool ActivePlay)
+{
+   mActivePlay = ActivePlay;
+
+   // A requested collection must not be held back by the delay
+   if (!mEnabled || !ActivePlay || mCollectRequested || !GEngine)
+      return;
+
+   if (IsUnderCeiling())
+   {
+      // Only holds the collection back for the next frame, so this has to be done every frame
+      GEngine->DelayGarbageCollection();
+   }
+}
+
+void FGarbageScheduler::RequestCollection()
+{
+   if (!mEnabled || mCollectRequested || !GEngine)
+      return;
+
+   mCollectRequested = true;
+   GEngine->ForceGarbageCollection(false);
+}
+
+void FGarbageScheduler::OnPostGarbageCollect()
+{
+   // Requested collections happen at chosen pauses, even if those are technically part of active play
+   mCollectionCount++;
+   if (mActivePlay && !mCollectRequested)
+   {
+      mActivePlayCollectionCount++;
+   }
+
+   mCollectRequested = false;
+}
+
+bool FGarbageScheduler::IsUnderCeiling() const
+{
+   return mMemoryCeiling == 0 || FPlatformMemory::GetStats().UsedPhysical < mMemoryCeiling;
+}
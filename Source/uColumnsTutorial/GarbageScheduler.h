@@ -0,0 +1,61 @@
+/**
+ * This source code is provided as reference/companion material for the uColumnsTutorial
+ * that can be freely found at http://www.kehomsforge.com and should not be commercialized
+ * in any form. It should remain free!
+ *
+ * By Yuri Sarudiansky
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Keeps the engine from collecting garbage while the game is in active play, requesting the collection at the natural
+// pauses instead. Deferring stops once the process uses more than the memory ceiling, so garbage can't pile up forever.
+// Collections are counted, separating the ones that were not requested and happened during active play
+struct UCOLUMNSTUTORIAL_API FGarbageScheduler
+{
+public:
+   FGarbageScheduler()
+      : mEnabled(true)
+      , mMemoryCeiling(0)
+      , mActivePlay(false)
+      , mCollectRequested(false)
+      , mCollectionCount(0)
+      , mActivePlayCollectionCount(0)
+   {}
+
+   // The post collection delegate is bound to this object, so it must never outlive it
+   ~FGarbageScheduler() { Shutdown(); }
+
+   // Start counting collections. Enabled tells if collections are deferred at all and CeilingMB is the memory ceiling
+   void Init(bool Enabled, float CeilingMB);
+
+   void Shutdown();
+
+   // Must be called every frame, after the engine had the chance to collect garbage
+   void Tick(bool ActivePlay);
+
+   // Collect the garbage on the next frame, even if in active play
+   void RequestCollection();
+
+   int32 GetCollectionCount() const { return mCollectionCount; }
+   int32 GetActivePlayCollectionCount() const { return mActivePlayCollectionCount; }
+
+private:
+   void OnPostGarbageCollect();
+
+   bool IsUnderCeiling() const;
+
+   FDelegateHandle mPostCollectHandle;
+
+   bool mEnabled;
+   uint64 mMemoryCeiling;
+
+   // State given to the last Tick(), which is where the engine is when it collects garbage
+   bool mActivePlay;
+   bool mCollectRequested;
+
+   int32 mCollectionCount;
+   int32 mActivePlayCollectionCount;
+};
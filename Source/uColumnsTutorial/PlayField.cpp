@@ -12,7 +12,36 @@
 #include "PaperSpriteComponent.h"
 #include "PaperSprite.h"
 #include "PaperTileSet.h"
+#include "PaperGroupedSpriteComponent.h"
 #include "ConstructorHelpers.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Materials/MaterialInstanceDynamic.h"
+#include "UObject/Package.h"
+
+
+namespace
+{
+   struct FGridMapKey
+   {
+      int32 ColumnCount;
+      int32 RowCount;
+      const UPaperTileSet* TileSet;
+
+      bool operator==(const FGridMapKey& Other) const
+      {
+         return ColumnCount == Other.ColumnCount && RowCount == Other.RowCount && TileSet == Other.TileSet;
+      }
+
+      friend uint32 GetTypeHash(const FGridMapKey& Key)
+      {
+         return HashCombine(HashCombine(GetTypeHash(Key.ColumnCount), GetTypeHash(Key.RowCount)), GetTypeHash(Key.TileSet));
+      }
+   };
+
+   // Generated grid tile maps. These are rooted, so they survive level changes
+   TMap<FGridMapKey, UPaperTileMap*> GridMapCache;
+}
 
 APlayField::APlayField()
 {
@@ -30,11 +59,26 @@ APlayField::APlayField()
    RootComponent->bVisible = false;
    RootComponent->SetMobility(EComponentMobility::Static);
 
+   mBlockSprite = nullptr;
+   mProceduralGridMaterial = nullptr;
+   mProceduralGridMinCells = 4096;
+   mGridQuadMaterial = nullptr;
+
    mTileMap = CreateDefaultSubobject<UPaperTileMapComponent>(TEXT("PlayfieldTileMap"));
    mTileMap->AttachToComponent(RootComponent, FAttachmentTransformRules::KeepRelativeTransform);
 
    static ConstructorHelpers::FObjectFinder<UMaterialInterface> tmap_mat(TEXT("/Paper2D/TranslucentUnlitSpriteMaterial"));
    mTileMap->SetMaterial(0, tmap_mat.Object);
+
+   // The engine plane lies on XY facing up, so rotate it to face the camera (which looks down the -Y axis)
+   mGridQuad = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("ProceduralGridQuad"));
+   mGridQuad->AttachToComponent(RootComponent, FAttachmentTransformRules::KeepRelativeTransform);
+   mGridQuad->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+   mGridQuad->SetRelativeRotation(FRotator(0.0f, 0.0f, -90.0f));
+   mGridQuad->SetVisibility(false);
+
+   static ConstructorHelpers::FObjectFinder<UStaticMesh> plane_mesh(TEXT("/Engine/BasicShapes/Plane"));
+   mGridQuad->SetStaticMesh(plane_mesh.Object);
 }
 
 void APlayField::OnConstruction(const FTransform& Transform)
@@ -49,8 +93,7 @@ void APlayField::OnConstruction(const FTransform& Transform)
    if (mTileMap->TileMap->TileLayers.Num() == 0)
       mTileMap->TileMap->AddNewLayer();
 
-   BuildGrid();
-   SetGridSprites();
+   RebuildGridMap();
 }
 
 void APlayField::Tick(float DeltaTime)
@@ -77,8 +120,29 @@ void APlayField::SetGridTileset(class UPaperTileSet* Tileset)
 
 void APlayField::RebuildGridMap()
 {
+   const bool procedural = UseProceduralGrid();
+   mTileMap->SetVisibility(!procedural);
+   mGridQuad->SetVisibility(procedural);
+
    BuildGrid();
-   SetGridSprites();
+
+   if (procedural)
+   {
+      SetupGridQuad();
+   }
+   else if (GetWorld() && GetWorld()->IsGameWorld())
+   {
+      // Generated maps can't be referenced by levels being edited, so the cache is only used while playing
+      UPaperTileMap* grid_map = GetCachedGridMap();
+      if (mTileMap->TileMap != grid_map)
+      {
+         mTileMap->SetTileMap(grid_map);
+      }
+   }
+   else
+   {
+      SetGridSprites();
+   }
 }
 
 
@@ -87,7 +151,10 @@ FVector APlayField::GetCellLocation(int32 Column, int32 Row) const
    if (!mTileMap)
       return FVector();
 
-   return mTileMap->GetTileCenterPosition(Column, Row, 0, true);
+   // The tile map is placed so the center of the first tile is at its origin, tiles going right and down from there.
+   // This doesn't require the tile map to hold any tile, which is the case with the procedural grid
+   const FVector local_location(Column * mTileSpriteSize, 0.0f, -Row * mTileSpriteSize);
+   return mTileMap->GetComponentTransform().TransformPosition(local_location);
 }
 
 
@@ -108,6 +175,127 @@ void APlayField::GetWorldGridLimits(FVector2D& OutTopLeft, FVector2D& OutBottomR
 
 
 
+void APlayField::InitBlockInstances(UPaperSprite* Sprite, const TArray<UMaterialInterface*>& TypeMaterial, const TArray<FLinearColor>& TypeColor)
+{
+   for (UPaperGroupedSpriteComponent* comp : mBlockInstances)
+   {
+      if (comp)
+      {
+         comp->DestroyComponent();
+      }
+   }
+   mBlockInstances.Empty();
+   mInstanceCell.Empty();
+
+   mBlockSprite = Sprite;
+   mTypeColor = TypeColor;
+   mTypeComponent.Init(-1, TypeMaterial.Num());
+
+   TArray<UMaterialInterface*> comp_material;
+   for (int32 type_id = 0; type_id < TypeMaterial.Num(); type_id++)
+   {
+      UMaterialInterface* material = TypeMaterial[type_id];
+
+      // Types sharing a material are drawn by the same component
+      int32 comp_index = comp_material.Find(material);
+      if (comp_index == INDEX_NONE)
+      {
+         UPaperGroupedSpriteComponent* comp = NewObject<UPaperGroupedSpriteComponent>(this);
+         comp->SetMobility(EComponentMobility::Movable);
+         comp->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+         comp->SetupAttachment(RootComponent);
+         comp->RegisterComponent();
+
+         // All instances of the component use the same sprite, so there is a single material slot
+         if (material)
+         {
+            comp->SetMaterial(0, material);
+         }
+
+         comp_index = mBlockInstances.Add(comp);
+         comp_material.Add(material);
+         mInstanceCell.AddDefaulted();
+      }
+      mTypeComponent[type_id] = comp_index;
+   }
+
+   const int32 cell_count = mColumnCount * mRowCount;
+   mCellInstance.Init(-1, cell_count);
+   mCellInstanceType.Init(-1, cell_count);
+}
+
+void APlayField::SetBlockInstance(int32 CellIndex, int32 TypeID, const FVector& Location)
+{
+   if (!mCellInstance.IsValidIndex(CellIndex) || !mTypeComponent.IsValidIndex(TypeID))
+      return;
+
+   const int32 comp_index = mTypeComponent[TypeID];
+   const FTransform instance_transform(FRotator::ZeroRotator, Location, FVector(mMapScale));
+
+   // Reuse the current instance if the cell already draws a block of this type
+   if (mCellInstanceType[CellIndex] == TypeID)
+   {
+      mBlockInstances[comp_index]->UpdateInstanceTransform(mCellInstance[CellIndex], instance_transform, true);
+      return;
+   }
+
+   ClearBlockInstance(CellIndex);
+
+   mCellInstance[CellIndex] = mBlockInstances[comp_index]->AddInstance(instance_transform, mBlockSprite, true, mTypeColor[TypeID]);
+   mCellInstanceType[CellIndex] = TypeID;
+   mInstanceCell[comp_index].Add(CellIndex);
+}
+
+void APlayField::ClearBlockInstance(int32 CellIndex)
+{
+   if (!HasBlockInstance(CellIndex))
+      return;
+
+   const int32 comp_index = mTypeComponent[mCellInstanceType[CellIndex]];
+   const int32 instance = mCellInstance[CellIndex];
+   UPaperGroupedSpriteComponent* comp = mBlockInstances[comp_index];
+   TArray<int32>& instance_cell = mInstanceCell[comp_index];
+   const int32 last = instance_cell.Num() - 1;
+
+   // Removing from the middle would shift every following instance, so the last one is moved into the hole instead
+   if (instance != last)
+   {
+      const int32 moved_cell = instance_cell[last];
+
+      FTransform last_transform;
+      comp->GetInstanceTransform(last, last_transform, true);
+      comp->UpdateInstanceTransform(instance, last_transform, true);
+      comp->UpdateInstanceColor(instance, mTypeColor[mCellInstanceType[moved_cell]]);
+
+      instance_cell[instance] = moved_cell;
+      mCellInstance[moved_cell] = instance;
+   }
+   comp->RemoveInstance(last);
+   instance_cell.Pop(false);
+
+   mCellInstance[CellIndex] = -1;
+   mCellInstanceType[CellIndex] = -1;
+}
+
+void APlayField::ClearBlockInstances()
+{
+   for (UPaperGroupedSpriteComponent* comp : mBlockInstances)
+   {
+      comp->ClearInstances();
+   }
+   for (TArray<int32>& instance_cell : mInstanceCell)
+   {
+      instance_cell.Reset();
+   }
+   for (int32 i = 0; i < mCellInstance.Num(); i++)
+   {
+      mCellInstance[i] = -1;
+      mCellInstanceType[i] = -1;
+   }
+}
+
+
+
 void APlayField::BeginPlay()
 {
    Super::BeginPlay();
@@ -117,14 +305,16 @@ void APlayField::BeginPlay()
 
 void APlayField::BuildGrid()
 {
-   // Used to obtain current tile map sizes
-   int32 mrows, mcols, mlayers;
-   mTileMap->GetMapSize(mcols, mrows, mlayers);
-
-   // Make sure the tile map is holding the correct grid size
-   if (mrows != mRowCount || mcols != mColumnCount)
+   // Make sure the tile map is holding the correct grid size. Cached and procedural grids don't use this one
+   if (mTileMap->OwnsTileMap() && !UseProceduralGrid())
    {
-      mTileMap->ResizeMap(mColumnCount, mRowCount);
+      int32 mrows, mcols, mlayers;
+      mTileMap->GetMapSize(mcols, mrows, mlayers);
+
+      if (mrows != mRowCount || mcols != mColumnCount)
+      {
+         mTileMap->ResizeMap(mColumnCount, mRowCount);
+      }
    }
 
    // Calculate map/tile scale factor
@@ -155,7 +345,10 @@ void APlayField::BuildGrid()
    const float zpos = (-mBackgroundSize.Y / 2.0f) + total_grid_height - half_cell;
 
    // Finally apply those values to the tile map
-   mTileMap->TileMap->TileWidth = mTileMap->TileMap->TileHeight = mTileSpriteSize;
+   if (mTileMap->OwnsTileMap())
+   {
+      mTileMap->TileMap->TileWidth = mTileMap->TileMap->TileHeight = mTileSpriteSize;
+   }
 
    mTileMap->SetRelativeScale3D(FVector(mMapScale, 1.0f, mMapScale));
    mTileMap->SetRelativeLocation(FVector(xpos, 0.0f, zpos));
@@ -179,3 +372,48 @@ void APlayField::SetGridSprites()
       }
    }
 }
+
+bool APlayField::UseProceduralGrid() const
+{
+   return mProceduralGridMaterial && (mColumnCount * mRowCount) >= mProceduralGridMinCells;
+}
+
+void APlayField::SetupGridQuad()
+{
+   if (!mGridQuadMaterial || mGridQuadMaterial->Parent != mProceduralGridMaterial)
+   {
+      mGridQuadMaterial = UMaterialInstanceDynamic::Create(mProceduralGridMaterial, this);
+      mGridQuad->SetMaterial(0, mGridQuadMaterial);
+   }
+   mGridQuadMaterial->SetScalarParameterValue(TEXT("ColumnCount"), mColumnCount);
+   mGridQuadMaterial->SetScalarParameterValue(TEXT("RowCount"), mRowCount);
+
+   // The plane mesh is 100 units wide and centered, while the tile map origin is at the center of the first tile
+   const float cell_size = GetScaledCellSize();
+   const float grid_width = mColumnCount * cell_size;
+   const float grid_height = mRowCount * cell_size;
+   const FVector first_cell = mTileMap->RelativeLocation;
+
+   mGridQuad->SetRelativeLocation(FVector(first_cell.X - cell_size / 2.0f + grid_width / 2.0f, first_cell.Y, first_cell.Z + cell_size / 2.0f - grid_height / 2.0f));
+   mGridQuad->SetRelativeScale3D(FVector(grid_width / 100.0f, grid_height / 100.0f, 1.0f));
+}
+
+UPaperTileMap* APlayField::GetCachedGridMap()
+{
+   const FGridMapKey key = { mColumnCount, mRowCount, mGridTileSet };
+   if (UPaperTileMap** cached = GridMapCache.Find(key))
+      return *cached;
+
+   // Let the component generate the map, then take it away from the component so it can be shared
+   UPaperTileMap* owned_map = mTileMap->TileMap;
+   mTileMap->CreateNewTileMap(mColumnCount, mRowCount, mTileSpriteSize, mTileSpriteSize, 1.0f, true);
+   SetGridSprites();
+
+   UPaperTileMap* grid_map = mTileMap->TileMap;
+   grid_map->Rename(nullptr, GetTransientPackage(), REN_DontCreateRedirectors | REN_ForceNoResetLoaders);
+   grid_map->AddToRoot();
+   GridMapCache.Add(key, grid_map);
+
+   mTileMap->TileMap = owned_map;
+   return grid_map;
+}
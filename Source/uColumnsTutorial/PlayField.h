@@ -40,6 +40,22 @@ public:
    void GetWorldGridLimits(FVector2D& OutTopLeft, FVector2D& OutBottomRight) const;
 
 
+   // Instanced block rendering. Blocks resting in the grid can be drawn as instances of grouped sprite components
+   // rather than each one being an actor. There is one component per distinct material, so types sharing a material
+   // (an atlas) are drawn together, each instance getting the color of its type
+   void InitBlockInstances(class UPaperSprite* Sprite, const TArray<class UMaterialInterface*>& TypeMaterial, const TArray<FLinearColor>& TypeColor);
+
+   // Draw a block of the specified type in the cell, at the given world location
+   void SetBlockInstance(int32 CellIndex, int32 TypeID, const FVector& Location);
+
+   // Stop drawing the block of the cell, if there is one
+   void ClearBlockInstance(int32 CellIndex);
+
+   void ClearBlockInstances();
+
+   bool HasBlockInstance(int32 CellIndex) const { return mCellInstance.IsValidIndex(CellIndex) && mCellInstance[CellIndex] >= 0; }
+
+
 protected:
    virtual void BeginPlay() override;
 
@@ -47,6 +63,16 @@ private:
    void BuildGrid();
    void SetGridSprites();
 
+   // Tell if the grid should be drawn by the procedural material rather than by the tile map
+   bool UseProceduralGrid() const;
+
+   // Size and parametrize the quad drawing the procedural grid
+   void SetupGridQuad();
+
+   // Obtain a tile map holding the grid sprites for the current size and tileset. Generated maps are shared by all
+   // play fields and kept for the rest of the session, since there are very few size/tileset combinations
+   class UPaperTileMap* GetCachedGridMap();
+
    UPROPERTY()
    int32 mRowCount;
 
@@ -68,7 +94,39 @@ private:
    UPROPERTY()
    class UPaperTileMapComponent* mTileMap;
 
+   // Material drawing the entire grid on a single quad. It receives the ColumnCount and RowCount scalar parameters,
+   // with the texture coordinates spanning the grid once. Used for boards with many cells
+   UPROPERTY(EditAnywhere, Category = "Performance", meta = (DisplayName = "Procedural Grid Material"))
+   class UMaterialInterface* mProceduralGridMaterial;
+
+   // Boards with at least this many cells use the procedural grid material, if one is set
+   UPROPERTY(EditAnywhere, Category = "Performance", meta = (DisplayName = "Procedural Grid Min Cells", ClampMin = 0))
+   int32 mProceduralGridMinCells;
+
+   UPROPERTY()
+   class UStaticMeshComponent* mGridQuad;
+
+   UPROPERTY()
+   class UMaterialInstanceDynamic* mGridQuadMaterial;
+
 
    UPROPERTY()
    float mMapScale;
+
+   // One grouped sprite component for each distinct block material
+   UPROPERTY()
+   TArray<class UPaperGroupedSpriteComponent*> mBlockInstances;
+
+   // Component index and instance color of each block type
+   TArray<int32> mTypeComponent;
+   TArray<FLinearColor> mTypeColor;
+
+   UPROPERTY()
+   class UPaperSprite* mBlockSprite;
+
+   // Instance index and type drawn in each cell (-1 if none)
+   TArray<int32> mCellInstance;
+   TArray<int32> mCellInstanceType;
+   // The cell of each instance, per component. Necessary to keep instances packed when one is removed
+   TArray<TArray<int32>> mInstanceCell;
 };
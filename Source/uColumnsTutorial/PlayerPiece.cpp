@@ -19,7 +19,7 @@ void FPlayerPiece::InitArray(int32 Size)
    }
 }
 
-void FPlayerPiece::Tick(float DeltaSeconds)
+void FPlayerPiece::Tick(float DeltaSeconds, FBlockMoveBatch& MoveBatch)
 {
    // Update the timing objects
    const float halpha = mIsSideMoving ? mHorizontalTime.Update(DeltaSeconds) : 0;
@@ -42,7 +42,7 @@ void FPlayerPiece::Tick(float DeltaSeconds)
       }
 
       // Update the actor location
-      block->SetActorLocation(interp_position);
+      MoveBatch.Add(block, interp_position);
    }
 }
 
@@ -25,7 +25,8 @@ public:
 
    void InitArray(int32 Size);
    
-   void Tick(float DeltaSeconds);
+   // Compute the new block locations, adding them into the batch rather than moving the blocks right away
+   void Tick(float DeltaSeconds, struct FBlockMoveBatch& MoveBatch);
 
    template <typename GetBlockFunc>
    void SpawnPiece(GetBlockFunc Func)
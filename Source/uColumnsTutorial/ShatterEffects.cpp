@@ -0,0 +1,90 @@
+/**
+ * This source code is provided as reference/companion material for the uColumnsTutorial
+ * that can be freely found at http://www.kehomsforge.com and should not be commercialized
+ * in any form. It should remain free!
+ *
+ * By Yuri Sarudiansky
+ */
+
+#include "ShatterEffects.h"
+#include "GameFramework/Actor.h"
+#include "Particles/ParticleSystem.h"
+#include "Particles/ParticleSystemComponent.h"
+
+const FName FShatterEffects::ColorParameter(TEXT("SparklesColorScale"));
+
+
+void FShatterEffects::Init(AActor* Owner, UParticleSystem* Template, int32 PoolSize)
+{
+   if (mTemplate == Template && mComponent.Num() == PoolSize)
+      return;
+
+   for (UParticleSystemComponent* comp : mComponent)
+   {
+      if (comp)
+      {
+         comp->DestroyComponent();
+      }
+   }
+   mComponent.Empty(PoolSize);
+   mPending.Reset();
+   mNextComponent = 0;
+
+   mTemplate = Template;
+   if (!Owner || !Template)
+      return;
+
+   for (int32 i = 0; i < PoolSize; i++)
+   {
+      UParticleSystemComponent* comp = NewObject<UParticleSystemComponent>(Owner);
+      comp->bAutoActivate = false;
+      comp->bAutoDestroy = false;
+      comp->SetAbsolute(true, true, true);
+      comp->SetTemplate(Template);
+      comp->RegisterComponent();
+      mComponent.Add(comp);
+   }
+}
+
+void FShatterEffects::AddBurst(const FVector& Location, const FLinearColor& Color, float Scale)
+{
+   if (!IsEnabled())
+      return;
+
+   FShatterBurst& burst = mPending[mPending.AddUninitialized()];
+   burst.Location = Location;
+   burst.Color = Color;
+   burst.Scale = Scale;
+}
+
+void FShatterEffects::Tick(int32 Budget)
+{
+   const int32 count = FMath::Min(Budget, mPending.Num());
+   if (count <= 0)
+      return;
+
+   for (int32 i = 0; i < count; i++)
+   {
+      const FShatterBurst& burst = mPending[i];
+
+      UParticleSystemComponent* comp = mComponent[mNextComponent];
+      mNextComponent = (mNextComponent + 1) % mComponent.Num();
+
+      comp->SetWorldLocation(burst.Location);
+      comp->SetWorldScale3D(FVector(burst.Scale));
+      comp->SetColorParameter(ColorParameter, burst.Color);
+      comp->Activate(true);
+   }
+
+   // Remaining bursts are played in the following frames, in the order they were added
+   mPending.RemoveAt(0, count, false);
+}
+
+void FShatterEffects::Reset()
+{
+   mPending.Reset();
+   for (UParticleSystemComponent* comp : mComponent)
+   {
+      comp->DeactivateSystem();
+   }
+}
@@ -0,0 +1,63 @@
+/**
+ * This source code is provided as reference/companion material for the uColumnsTutorial
+ * that can be freely found at http://www.kehomsforge.com and should not be commercialized
+ * in any form. It should remain free!
+ *
+ * By Yuri Sarudiansky
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ShatterEffects.generated.h"
+
+// A shatter effect waiting to be played
+struct FShatterBurst
+{
+   FVector Location;
+   FLinearColor Color;
+   float Scale;
+};
+
+
+// Plays shatter particle effects through a fixed set of particle system components, reused in round robin fashion.
+// Bursts are queued and at most a budget of them is started per frame, so the cost is bounded no matter how many
+// blocks are removed at once. If all components are busy the oldest effect is restarted at the new location
+USTRUCT()
+struct UCOLUMNSTUTORIAL_API FShatterEffects
+{
+   GENERATED_USTRUCT_BODY()
+public:
+   FShatterEffects()
+      : mTemplate(nullptr)
+      , mNextComponent(0)
+   {}
+
+   // Create the components, owned by the specified actor. Calling this again with another template rebuilds the pool
+   void Init(AActor* Owner, class UParticleSystem* Template, int32 PoolSize);
+
+   bool IsEnabled() const { return mTemplate && mComponent.Num() > 0; }
+
+   // Queue an effect to be played
+   void AddBurst(const FVector& Location, const FLinearColor& Color, float Scale);
+
+   // Start up to Budget of the queued effects
+   void Tick(int32 Budget);
+
+   // Drop the queued effects and stop the active ones
+   void Reset();
+
+   // Name of the color parameter of the particle system
+   static const FName ColorParameter;
+
+private:
+   UPROPERTY()
+   class UParticleSystem* mTemplate;
+
+   UPROPERTY()
+   TArray<class UParticleSystemComponent*> mComponent;
+
+   TArray<FShatterBurst> mPending;
+
+   int32 mNextComponent;
+};
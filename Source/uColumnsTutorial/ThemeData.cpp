@@ -0,0 +1,47 @@
+/**
+ * This source code is provided as reference/companion material for the uColumnsTutorial
+ * that can be freely found at http://www.kehomsforge.com and should not be commercialized
+ * in any form. It should remain free!
+ *
+ * By Yuri Sarudiansky
+ */
+
+#include "ThemeData.h"
+
+
+void FThemeTable::Build(UThemeData* NewTheme)
+{
+   Theme = NewTheme;
+   mType.Reset();
+
+   if (!Theme)
+   {
+      BlockSprite = nullptr;
+      LandingSound = nullptr;
+      RemovingSound = nullptr;
+      return;
+   }
+
+   BlockSprite = Theme->BlockSprite;
+   LandingSound = Theme->LandingBlockSound;
+   RemovingSound = Theme->RemovingBlockSound;
+
+   const bool use_atlas = Theme->HasBlockAtlas();
+   if (!use_atlas && Theme->IsBlockAtlasSet())
+   {
+      UE_LOG(LogTemp, Warning, TEXT("Theme '%s' has %d block types but its atlas only holds %d, using the block materials instead"), *Theme->GetName(), Theme->BlockCollection.Num(), Theme->GetBlockAtlasCapacity());
+   }
+   const int32 type_count = Theme->BlockCollection.Num();
+   mType.SetNum(type_count);
+   for (int32 type_id = 0; type_id < type_count; type_id++)
+   {
+      const FBlockData& bdata = Theme->BlockCollection[type_id];
+      FThemeTypeEntry& entry = mType[type_id];
+
+      entry.BlockClass = bdata.BlockClass ? *bdata.BlockClass : ABlock::StaticClass();
+      entry.Material = use_atlas ? Theme->BlockAtlasMaterial : bdata.Material;
+      entry.SpriteColor = use_atlas ? Theme->GetBlockAtlasColor(type_id) : FLinearColor::White;
+      entry.ParticlesColor = bdata.ParticlesColor;
+      entry.Weight = bdata.ProbabilityWeight;
+   }
+}
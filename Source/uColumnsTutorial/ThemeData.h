@@ -55,8 +55,40 @@ public:
       , GridTileSet(nullptr)
       , LandingBlockSound(nullptr)
       , RemovingBlockSound(nullptr)
+      , BlockAtlas(nullptr)
+      , BlockAtlasMaterial(nullptr)
+      , BlockAtlasColumns(4)
+      , BlockAtlasRows(4)
    {}
 
+   // Tell if the blocks of this theme should be rendered from the atlas rather than with their own materials. An atlas
+   // grid without a cell for every block type is ignored, falling back to the materials of the block collection
+   bool HasBlockAtlas() const { return IsBlockAtlasSet() && BlockCollection.Num() <= GetBlockAtlasCapacity(); }
+
+   // Tell if the atlas properties are set, regardless of the atlas grid being large enough
+   bool IsBlockAtlasSet() const { return BlockAtlas && BlockAtlasMaterial && BlockAtlasColumns > 0 && BlockAtlasRows > 0; }
+
+   // Amount of block types the atlas grid can hold
+   int32 GetBlockAtlasCapacity() const { return BlockAtlasColumns * BlockAtlasRows; }
+
+   // Texture coordinates of the atlas cell holding the block type. Cells are assigned by type ID, left to right
+   // then top to bottom
+   FBox2D GetBlockAtlasUV(int32 TypeID) const
+   {
+      const FVector2D cell_size(1.0f / BlockAtlasColumns, 1.0f / BlockAtlasRows);
+      const FVector2D cell_min(cell_size.X * (TypeID % BlockAtlasColumns), cell_size.Y * (TypeID / BlockAtlasColumns));
+      return FBox2D(cell_min, cell_min + cell_size);
+   }
+
+   // The atlas cell of the block type, encoded into the sprite color so every block can share the atlas material.
+   // Red and green hold the column and row of the cell, divided by 255. The material is expected to compute the
+   // texture coordinates as (round(VertexColor.RG * 255) + TexCoord) / (BlockAtlasColumns, BlockAtlasRows), as the
+   // reference material in RawAssets/Materials does
+   FLinearColor GetBlockAtlasColor(int32 TypeID) const
+   {
+      return FLinearColor((TypeID % BlockAtlasColumns) / 255.0f, (TypeID / BlockAtlasColumns) / 255.0f, 0.0f, 1.0f);
+   }
+
    // The name of the theme. This will be shown in the game menus
    UPROPERTY(EditAnywhere, BlueprintReadOnly)
    FString ThemeName;
@@ -86,4 +118,80 @@ public:
    // Specify the blocks that are part of this theme
    UPROPERTY(EditAnywhere, BlueprintReadWrite)
    TArray<FBlockData> BlockCollection;
+
+
+   // Optional texture holding the images of all block types, in a grid with one cell per type ID. When set along
+   // with the atlas material, the material of each FBlockData entry is not used for rendering
+   UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Block Atlas")
+   class UTexture2D* BlockAtlas;
+
+   // Single material used by every block when the atlas is set, selecting the atlas cell from the sprite color.
+   // The BlockSprite must cover its entire texture so the texture coordinates span 0-1
+   UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Block Atlas")
+   UMaterialInterface* BlockAtlasMaterial;
+
+   UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Block Atlas", meta = (ClampMin = 1, ClampMax = 255))
+   int32 BlockAtlasColumns;
+
+   UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Block Atlas", meta = (ClampMin = 1, ClampMax = 255))
+   int32 BlockAtlasRows;
+};
+
+
+
+// Everything needed from the theme about a single block type, already resolved
+struct FThemeTypeEntry
+{
+   FThemeTypeEntry()
+      : BlockClass(nullptr)
+      , Material(nullptr)
+      , SpriteColor(FLinearColor::White)
+      , ParticlesColor(FLinearColor::White)
+      , Weight(0.0f)
+   {}
+
+   // Never null, blocks without a class use the base one
+   UClass* BlockClass;
+   // The atlas material when the theme has an atlas, otherwise the block material
+   UMaterialInterface* Material;
+   // Selects the atlas cell when the theme has an atlas, otherwise white
+   FLinearColor SpriteColor;
+   FLinearColor ParticlesColor;
+   float Weight;
+};
+
+
+// The theme compiled into a contiguous table indexed by block type ID, so per block lookups are a single array index
+// rather than going through the game instance and the asset. Built when the theme is selected
+USTRUCT()
+struct UCOLUMNSTUTORIAL_API FThemeTable
+{
+   GENERATED_USTRUCT_BODY()
+public:
+   FThemeTable()
+      : Theme(nullptr)
+      , BlockSprite(nullptr)
+      , LandingSound(nullptr)
+      , RemovingSound(nullptr)
+   {}
+
+   // Rebuild the table from the theme, which may be null to clear it
+   void Build(UThemeData* NewTheme);
+
+   int32 Num() const { return mType.Num(); }
+
+   bool IsValidType(int32 TypeID) const { return mType.IsValidIndex(TypeID); }
+
+   const FThemeTypeEntry& operator[](int32 TypeID) const { return mType[TypeID]; }
+
+   // The table is not a UObject so this keeps every object it points to alive
+   UPROPERTY()
+   UThemeData* Theme;
+
+   class UPaperSprite* BlockSprite;
+   USoundWave* LandingSound;
+   USoundWave* RemovingSound;
+
+private:
+   TArray<FThemeTypeEntry> mType;
 };
@@ -11,29 +11,6 @@
 #include "CoreMinimal.h"
 #include "helpers.generated.h"
 
-USTRUCT()
-struct FGridCellData
-{
-   GENERATED_USTRUCT_BODY()
-public:
-   explicit FGridCellData(int32 MapCol = 0, int32 MapRow = 0)
-      : TileMapColumn(MapCol)
-      , TileMapRow(MapRow)
-      , BlockActor(nullptr)
-   {}
-
-   UPROPERTY()
-   int32 TileMapColumn;
-
-   UPROPERTY()
-   int32 TileMapRow;
-
-   UPROPERTY()
-   class ABlock* BlockActor;
-};
-
-
-
 USTRUCT()
 struct FTiming
 {
@@ -64,23 +41,38 @@ private:
 };
 
 
-struct FRepositioningBlock
+// Copy of the game instance settings used by the game mode, captured when a game begins so hot paths read plain
+// fields instead of looking up the game instance. The defaults are the ones used when there is no game instance
+struct FColRuleSet
 {
-public:
-   explicit FRepositioningBlock(float TimeLimit = 0.0f, int32 Index = -1, class ABlock* Block = nullptr)
-      : BlockActor(Block)
-      , CellIndex(Index)
-      , RepositionFinished(false)
-   {
-      Timing.Set(TimeLimit);
-   }
+   FColRuleSet()
+      : MatchRunSize(3)
+      , MatchDiagonal(true)
+      , PlayerPieceSize(3)
+      , ShiftDelay(0.2f)
+      , SideMoveDelay(0.35f)
+      , HorizontalMoveTime(0.2f)
+      , VerticalMoveTime(0.5f)
+      , VerticalFastMultiplier(5.0f)
+      , RepositionMoveTime(0.35f)
+      , BlinkingSpeed(5.0f)
+      , BlinkingTime(0.8f)
+   {}
 
-   FTiming Timing;
-   int32 CellIndex;
-   class ABlock* BlockActor;
-   bool RepositionFinished;
+   int32 MatchRunSize;
+   bool MatchDiagonal;
+   int32 PlayerPieceSize;
+   float ShiftDelay;
+   float SideMoveDelay;
+   float HorizontalMoveTime;
+   float VerticalMoveTime;
+   float VerticalFastMultiplier;
+   float RepositionMoveTime;
+   float BlinkingSpeed;
+   float BlinkingTime;
 };
 
+
 USTRUCT(BlueprintType)
 struct FHighScoreContainer
 {
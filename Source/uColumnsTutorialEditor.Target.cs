@@ -9,6 +9,6 @@ public class uColumnsTutorialEditorTarget : TargetRules
 	{
 		Type = TargetType.Editor;
 
-		ExtraModuleNames.AddRange( new string[] { "uColumnsTutorial" } );
+		ExtraModuleNames.AddRange( new string[] { "uColumnsTutorial", "ColumnsCore" } );
 	}
 }